@@ -0,0 +1,255 @@
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hal_fake_ptu/axis_model.hpp"
+
+#include "hal_fake_ptu/motion_engine.hpp"
+#include "hal_fake_ptu/pty_server.hpp"
+#include "hal_fake_ptu/serial_protocol.hpp"
+#include "hal_fake_ptu/shared_state.hpp"
+#include "hal_fake_ptu/shared_state_writer.hpp"
+#include "hal_fake_ptu/timer_wheel.hpp"
+#include "hal_fake_ptu/trace_buffer.hpp"
+#include "hal_fake_ptu/trajectory.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+constexpr int64_t TICK_NS = 10000000;
+
+const std::array<AxisConfig, AXIS_COUNT> axes{{{0.1, 0.2, 0.01}, {0.1, 0.2, 0.01}}};
+
+// Serial handlers on a unit whose moves settle at once, so only the front end is measured
+SerialHandlers instant_handlers() {
+    SerialHandlers handlers;
+    handlers.state = []() { return PTUState(); };
+    handlers.range = [](Axis) { return std::make_pair(-1.0, 1.0); };
+    handlers.move = [](Axis, double, std::function<void()> settled) { settled(); };
+    handlers.set_speed = [](Axis, double) {};
+    handlers.halt = [](Axis) {};
+    handlers.reset = []() {};
+    return handlers;
+}
+
+std::string pipelined_commands(int64_t count) {
+    std::string commands;
+    for (int64_t i = 0; i < count; i++)
+        commands += i % 2 ? "PP " : "PP" + std::to_string(i % 1000) + " ";
+    return commands;
+}
+
+}  // namespace
+
+
+static void BM_PlanProfile(benchmark::State & state) {
+    double target = 0.5;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(TrapezoidalProfile::plan({0.1, 0.05}, target, {0.1, 0.2}, 0));
+        target = -target;
+    }
+}
+BENCHMARK(BM_PlanProfile);
+
+
+static void BM_EvaluateProfile(benchmark::State & state) {
+    TrapezoidalProfile profile = TrapezoidalProfile::plan({0.0, 0.0}, 0.7, {0.1, 0.2}, 0);
+    int64_t stamp_ns = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(profile.at(stamp_ns));
+        stamp_ns = (stamp_ns + 1234567) % profile.end();
+    }
+}
+BENCHMARK(BM_EvaluateProfile);
+
+
+// One engine tick with every axis of every unit moving
+static void BM_TickMoving(benchmark::State & state) {
+    const std::size_t units = static_cast<std::size_t>(state.range(0));
+    MotionEngine engine(units, axes);
+    int64_t stamp_ns = 0;
+    double pan = 0.5;
+
+    auto post_all = [&]() {
+        pan = -pan;
+        for (std::size_t unit = 0; unit < units; unit++) {
+            MoveCommand command;
+            command.unit = unit;
+            command.active = {{true, true}};
+            command.target = {{pan, -pan}};
+            command.on_progress = [](const AxisValues &) {};
+            engine.post(std::move(command));
+        }
+        engine.tick(stamp_ns += TICK_NS);
+    };
+    post_all();
+
+    for (auto _ : state) {
+        engine.tick(stamp_ns += TICK_NS);
+        if (not engine.sample(0, stamp_ns).moving[PAN]) {
+            state.PauseTiming();
+            post_all();
+            state.ResumeTiming();
+        }
+    }
+    state.counters["axes"] = static_cast<double>(units * AXIS_COUNT);
+    state.SetItemsProcessed(state.iterations() * units);
+}
+BENCHMARK(BM_TickMoving)->Arg(1)->Arg(8)->Arg(64);
+
+
+static void BM_TickIdle(benchmark::State & state) {
+    MotionEngine engine(static_cast<std::size_t>(state.range(0)), axes);
+    int64_t stamp_ns = 0;
+    for (auto _ : state)
+        engine.tick(stamp_ns += TICK_NS);
+}
+BENCHMARK(BM_TickIdle)->Arg(1)->Arg(64);
+
+
+static void BM_SampleState(benchmark::State & state) {
+    MotionEngine engine(1, axes);
+    int64_t stamp_ns = 0;
+    for (auto _ : state)
+        benchmark::DoNotOptimize(engine.sample(0, stamp_ns += TICK_NS));
+}
+BENCHMARK(BM_SampleState);
+
+
+static void BM_TraceRecord(benchmark::State & state) {
+    static TraceBuffer trace(1 << 16);
+    int64_t stamp_ns = 0;
+    for (auto _ : state)
+        trace.record(TraceEvent::SAMPLE, stamp_ns++, 0, 0, 0.1, 0.2);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TraceRecord)->Threads(1)->Threads(4);
+
+
+// One model step of a fleet of axes, per axis; range(1) is the AxisEffect mask
+static void BM_AxisModels(benchmark::State & state) {
+    const std::size_t count = static_cast<std::size_t>(state.range(0));
+    AxisModelConfig config;
+    config.lag = 0.05;
+    config.max_velocity = 0.5;
+    config.max_acceleration = 2.0;
+    config.backlash = 0.001;
+    config.noise = 0.0005;
+    config.resolution = 0.0001;
+    AxisModelBank bank(std::vector<AxisModelConfig>(count, config),
+                       std::vector<unsigned>(count, static_cast<unsigned>(state.range(1))));
+
+    std::vector<double> command(count, 0.0);
+    double target = 0.5;
+    int step = 0;
+    for (auto _ : state) {
+        if (++step % 200 == 0) {
+            target = -target;
+            std::fill(command.begin(), command.end(), target);
+        }
+        bank.step(command.data(), 0.01);
+        benchmark::DoNotOptimize(bank.position_of(0));
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_AxisModels)->Args({128, 0})->Args({128, AXIS_EFFECT_MASK})->Args({4096, AXIS_EFFECT_MASK});
+
+// Parsing and answering a buffer of pipelined position commands and queries
+static void BM_SerialParse(benchmark::State & state) {
+    SerialProtocol protocol(instant_handlers(), 0.001);
+    const std::string commands = pipelined_commands(state.range(0));
+    std::string output;
+    output.reserve(commands.size() * 4);
+    for (auto _ : state) {
+        output.clear();
+        benchmark::DoNotOptimize(protocol.execute(commands, output));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SerialParse)->Arg(256);
+
+
+// Commands written to the pty slave in one go, until every response is read back
+static void BM_SerialRoundTrip(benchmark::State & state) {
+    SerialProtocol protocol(instant_handlers(), 0.001);
+    PtyServer server(protocol);
+    server.start();
+    const int port = open(server.device().c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    const std::string commands = pipelined_commands(state.range(0));
+    char buffer[4096];
+
+    for (auto _ : state) {
+        std::size_t sent = 0;
+        int64_t lines = 0;
+        while (lines < state.range(0)) {
+            if (sent < commands.size()) {
+                const ssize_t count = write(port, commands.data() + sent, commands.size() - sent);
+                if (count > 0)
+                    sent += static_cast<std::size_t>(count);
+            }
+            const ssize_t count = read(port, buffer, sizeof(buffer));
+            for (ssize_t i = 0; i < count; i++)
+                lines += buffer[i] == '\n';
+        }
+    }
+    close(port);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SerialRoundTrip)->Arg(1)->Arg(1000)->UseRealTime();
+
+// Sampling a pose from the shared memory segment, with the engine writing it or not
+static void BM_SharedStateRead(benchmark::State & state) {
+    const std::string name = "/hal_fake_ptu_bench_" + std::to_string(getpid());
+    auto writer = SharedStateWriter::create(name, 1);
+    auto reader = SharedStateReader::open(name);
+    std::atomic<bool> done{false};
+    std::thread writing;
+    if (state.range(0)) {
+        writing = std::thread([&]() {
+            PTUState sample;
+            while (not done.load(std::memory_order_relaxed)) {
+                sample.stamp_ns++;
+                writer->write(0, sample);
+            }
+        });
+    }
+    for (auto _ : state)
+        benchmark::DoNotOptimize(reader->read(0));
+    done.store(true);
+    if (writing.joinable())
+        writing.join();
+}
+BENCHMARK(BM_SharedStateRead)->Arg(0)->Arg(1);
+
+// One engine tick of a wheel holding range(0) responses delayed by up to 2 s
+static void BM_TimerWheelTick(benchmark::State & state) {
+    constexpr int64_t TICK_NS = 10000000;
+    TimerWheel wheel(TICK_NS);
+    const int64_t pending = state.range(0);
+    int64_t now_ns = 0;
+    uint64_t fired = 0;
+    auto fire = [&fired](){ fired++; };
+    for (int64_t i = 0; i < pending; i++)
+        wheel.schedule(i * 2000000000 / pending, fire);
+    wheel.advance(now_ns);
+    for (auto _ : state) {
+        // Keep the wheel as full as it started: each one run is scheduled again 2 s out
+        now_ns += TICK_NS;
+        const uint64_t before = fired;
+        wheel.advance(now_ns);
+        for (uint64_t i = before; i < fired; i++)
+            wheel.schedule(now_ns + 2000000000, fire);
+    }
+    state.counters["pending"] = static_cast<double>(wheel.pending());
+}
+BENCHMARK(BM_TimerWheelTick)->Arg(0)->Arg(1000)->Arg(100000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,268 @@
+// End-to-end latency of the simulator's ROS interfaces, measured in-process
+// against a node spinning on its own executor. Run with
+//   bench_latency --benchmark_out=latency.json --benchmark_out_format=json
+// to get machine-readable results.
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_action/rclcpp_action.hpp"
+
+#include "lifecycle_msgs/msg/transition.hpp"
+#include "lifecycle_msgs/srv/change_state.hpp"
+#include "ptu_interfaces/msg/ptu.hpp"
+#include "ptu_interfaces/srv/set_pan.hpp"
+#include "ptu_interfaces/action/set_pan.hpp"
+
+#include "hal_fake_ptu/action/follow_waypoints.hpp"
+#include "hal_fake_ptu/hal_fake_ptu.hpp"
+
+using namespace std::chrono_literals;
+using Clock = std::chrono::steady_clock;
+using SetPanAction = ptu_interfaces::action::SetPan;
+using FollowWaypointsAction = hal_fake_ptu::action::FollowWaypoints;
+
+namespace {
+
+constexpr double STATE_HZ = 100.0;
+
+rclcpp::Node::SharedPtr client_node;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+
+// set_pan to where the pan already is: answered at the next engine tick
+static void BM_ServiceRoundTrip(benchmark::State & state) {
+    auto client = client_node->create_client<ptu_interfaces::srv::SetPan>("/ptu/set_pan");
+    if (not client->wait_for_service(5s)) {
+        state.SkipWithError("set_pan service not available");
+        return;
+    }
+
+    auto request = std::make_shared<ptu_interfaces::srv::SetPan::Request>();
+    request->pan = 0.0;
+    for (auto _ : state) {
+        auto result = client->async_send_request(request);
+        if (result.future.wait_for(5s) != std::future_status::ready) {
+            state.SkipWithError("set_pan timed out");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ServiceRoundTrip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+
+// Every thread has its own client, so the service sees state.threads() callers at once
+static void BM_ConcurrentClients(benchmark::State & state) {
+    auto client = client_node->create_client<ptu_interfaces::srv::SetPan>("/ptu/set_pan");
+    if (not client->wait_for_service(5s)) {
+        state.SkipWithError("set_pan service not available");
+        return;
+    }
+
+    auto request = std::make_shared<ptu_interfaces::srv::SetPan::Request>();
+    request->pan = 0.0;
+    for (auto _ : state) {
+        auto result = client->async_send_request(request);
+        if (result.future.wait_for(5s) != std::future_status::ready) {
+            state.SkipWithError("set_pan timed out");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConcurrentClients)->Unit(benchmark::kMicrosecond)->UseRealTime()->ThreadRange(1, 16);
+
+
+// Short pan moves back and forth; reports accept-to-first-feedback as a
+// counter and accept-to-result as the iteration time
+static void BM_ActionLatency(benchmark::State & state) {
+    auto client = rclcpp_action::create_client<SetPanAction>(client_node, "/ptu/set_pan");
+    if (not client->wait_for_action_server(5s)) {
+        state.SkipWithError("set_pan action not available");
+        return;
+    }
+
+    double first_feedback_total = 0.0;
+    double target = 0.02;
+    for (auto _ : state) {
+        std::promise<void> done;
+        std::atomic<bool> got_feedback{false};
+        Clock::time_point accepted = Clock::now();
+        double first_feedback = 0.0;
+
+        rclcpp_action::Client<SetPanAction>::SendGoalOptions options;
+        options.goal_response_callback = [&](rclcpp_action::ClientGoalHandle<SetPanAction>::SharedPtr) {
+            accepted = Clock::now();
+        };
+        options.feedback_callback = [&](rclcpp_action::ClientGoalHandle<SetPanAction>::SharedPtr,
+                                        const std::shared_ptr<const SetPanAction::Feedback>) {
+            if (not got_feedback.exchange(true))
+                first_feedback = seconds_since(accepted);
+        };
+        options.result_callback = [&](const rclcpp_action::ClientGoalHandle<SetPanAction>::WrappedResult &) {
+            state.SetIterationTime(seconds_since(accepted));
+            done.set_value();
+        };
+
+        SetPanAction::Goal goal;
+        goal.pan = target;
+        target = -target;
+        client->async_send_goal(goal, options);
+        if (done.get_future().wait_for(10s) != std::future_status::ready) {
+            state.SkipWithError("set_pan goal timed out");
+            return;
+        }
+        first_feedback_total += first_feedback;
+    }
+    state.counters["first_feedback_s"] = benchmark::Counter(first_feedback_total, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ActionLatency)->Unit(benchmark::kMillisecond)->UseManualTime()->Iterations(50);
+
+
+// Raster of range(0) points 0.01 apart in one goal, blended; reports points per second
+static void BM_WaypointThroughput(benchmark::State & state) {
+    auto client = rclcpp_action::create_client<FollowWaypointsAction>(client_node, "/ptu/follow_waypoints");
+    if (not client->wait_for_action_server(5s)) {
+        state.SkipWithError("follow_waypoints action not available");
+        return;
+    }
+
+    FollowWaypointsAction::Goal goal;
+    goal.blend_radius = 0.005;
+    for (int64_t i = 0; i < state.range(0); i++) {
+        hal_fake_ptu::msg::PanTiltWaypoint waypoint;
+        waypoint.pan = (i % 10) * 0.01;
+        waypoint.tilt = (i / 10) % 10 * 0.01;
+        goal.waypoints.push_back(waypoint);
+    }
+
+    for (auto _ : state) {
+        std::promise<bool> done;
+        rclcpp_action::Client<FollowWaypointsAction>::SendGoalOptions options;
+        options.result_callback = [&](const rclcpp_action::ClientGoalHandle<FollowWaypointsAction>::WrappedResult & result) {
+            done.set_value(result.result->ret);
+        };
+        client->async_send_goal(goal, options);
+        auto result = done.get_future();
+        if (result.wait_for(120s) != std::future_status::ready or not result.get()) {
+            state.SkipWithError("follow_waypoints goal failed");
+            return;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WaypointThroughput)->Arg(100)->Iterations(3)->Unit(benchmark::kSecond)->UseRealTime();
+
+
+// Deviation of /ptu/state inter-arrival times from 1 / hz
+static void BM_StatePublishJitter(benchmark::State & state) {
+    const double period = 1.0 / STATE_HZ;
+    const std::size_t samples = static_cast<std::size_t>(state.range(0));
+
+    for (auto _ : state) {
+        std::mutex mutex;
+        std::vector<Clock::time_point> arrivals;
+        arrivals.reserve(samples + 1);
+        std::promise<void> done;
+
+        auto subscription = client_node->create_subscription<ptu_interfaces::msg::PTU>("/ptu/state", 10,
+            [&](const ptu_interfaces::msg::PTU::ConstSharedPtr) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (arrivals.size() > samples)
+                    return;
+                arrivals.push_back(Clock::now());
+                if (arrivals.size() == samples + 1)
+                    done.set_value();
+            });
+        if (done.get_future().wait_for(std::chrono::duration<double>(samples * period * 4 + 5.0)) != std::future_status::ready) {
+            state.SkipWithError("not enough /ptu/state messages");
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        double sum = 0.0, worst = 0.0;
+        for (std::size_t i = 1; i < arrivals.size(); i++) {
+            double error = std::abs(std::chrono::duration<double>(arrivals[i] - arrivals[i - 1]).count() - period);
+            sum += error;
+            worst = std::max(worst, error);
+        }
+        state.counters["jitter_mean_s"] = sum / samples;
+        state.counters["jitter_max_s"] = worst;
+    }
+}
+BENCHMARK(BM_StatePublishJitter)->Arg(500)->Iterations(1)->Unit(benchmark::kSecond);
+
+
+// deactivate, cleanup, configure, activate through the lifecycle service,
+// as a test harness does between scenarios; one iteration is the whole cycle
+static void BM_ScenarioCycle(benchmark::State & state) {
+    using lifecycle_msgs::msg::Transition;
+    auto client = client_node->create_client<lifecycle_msgs::srv::ChangeState>("/hal_fake_ptu/change_state");
+    if (not client->wait_for_service(5s)) {
+        state.SkipWithError("change_state service not available");
+        return;
+    }
+
+    const uint8_t cycle[] = {Transition::TRANSITION_DEACTIVATE, Transition::TRANSITION_CLEANUP,
+                             Transition::TRANSITION_CONFIGURE, Transition::TRANSITION_ACTIVATE};
+    auto request = std::make_shared<lifecycle_msgs::srv::ChangeState::Request>();
+    for (auto _ : state) {
+        for (uint8_t transition : cycle) {
+            request->transition.id = transition;
+            auto result = client->async_send_request(request);
+            if (result.future.wait_for(5s) != std::future_status::ready or not result.future.get()->success) {
+                state.SkipWithError("lifecycle transition failed");
+                return;
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ScenarioCycle)->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(100);
+
+
+int main(int argc, char ** argv) {
+    rclcpp::init(argc, argv);
+    benchmark::Initialize(&argc, argv);
+
+    rclcpp::NodeOptions options;
+    options.append_parameter_override("hz", STATE_HZ);
+    options.append_parameter_override("publishing.adaptive", false);
+    options.append_parameter_override("trace.dump_on_shutdown", false);
+    auto sim_node = hal_fake_ptu::make_node(options);
+    client_node = std::make_shared<rclcpp::Node>("hal_fake_ptu_bench");
+
+    rclcpp::executors::MultiThreadedExecutor sim_exec;
+    rclcpp::executors::MultiThreadedExecutor client_exec;
+    sim_exec.add_node(sim_node->get_node_base_interface());
+    client_exec.add_node(client_node);
+    std::thread sim_thread([&sim_exec]() { sim_exec.spin(); });
+    std::thread client_thread([&client_exec]() { client_exec.spin(); });
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    sim_exec.cancel();
+    client_exec.cancel();
+    sim_thread.join();
+    client_thread.join();
+    client_node.reset();
+    rclcpp::shutdown();
+    return 0;
+}
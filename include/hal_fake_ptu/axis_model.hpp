@@ -0,0 +1,184 @@
+#ifndef HAL_FAKE_PTU__AXIS_MODEL_HPP_
+#define HAL_FAKE_PTU__AXIS_MODEL_HPP_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace hal_fake_ptu {
+
+// Imperfections between the commanded trajectory and what the encoder reports.
+enum AxisEffect : unsigned {
+    LAG = 1,           // first-order motor response
+    SATURATION = 2,    // motor velocity and acceleration limits
+    BACKLASH = 4,      // gear play
+    NOISE = 8,         // seeded sensor noise
+    QUANTIZATION = 16, // encoder resolution
+    AXIS_EFFECT_MASK = 31
+};
+
+// Parses "lag", "saturation", "backlash", "noise" and "quantization" into
+// an AxisEffect mask, throws std::invalid_argument on anything else.
+unsigned axis_effects_from_strings(const std::vector<std::string> & names);
+
+struct AxisModelConfig {
+    double lag = 0.0;               // time constant, seconds
+    double max_velocity = 0.0;      // 0 = unlimited
+    double max_acceleration = 0.0;  // 0 = unlimited
+    double backlash = 0.0;          // full width of the play
+    double noise = 0.0;             // standard deviation
+    double resolution = 0.0;        // encoder step
+    uint64_t seed = 0;
+};
+
+// What the effects remember from one tick to the next.
+struct AxisModelState {
+    double lagged = 0.0;
+    double position = 0.0;
+    double velocity = 0.0;
+    double play = 0.0;
+    uint64_t rng = 0;
+};
+
+namespace axis_policy {
+
+// Each policy maps the signal coming out of the previous one; stateless
+// ones and disabled slots compile down to nothing.
+
+struct Passthrough {
+    static double apply(const AxisModelConfig &, AxisModelState &, double x, double) { return x; }
+};
+
+struct MotorLag {
+    static double apply(const AxisModelConfig & config, AxisModelState & state, double x, double dt) {
+        // No lag and no time (the first step) would be 0 / 0
+        if (config.lag + dt <= 0.0)
+            state.lagged = x;
+        else
+            state.lagged += (x - state.lagged) * dt / (config.lag + dt);
+        return state.lagged;
+    }
+};
+
+// Tracks the input at no more than the motor limits, braking in time to
+// stop on it instead of overshooting
+struct Saturation {
+    static double apply(const AxisModelConfig & config, AxisModelState & state, double x, double dt) {
+        if (dt <= 0.0)
+            return state.position;
+        const double error = x - state.position;
+        double speed = std::abs(error) / dt;
+        if (config.max_acceleration > 0.0) {
+            // Fastest speed that still stops on the input, decelerating once per step
+            const double step = config.max_acceleration * dt;
+            speed = std::min(speed, step * (std::sqrt(0.25 + 2.0 * std::abs(error) / (step * dt)) - 0.5));
+        }
+        if (config.max_velocity > 0.0)
+            speed = std::min(speed, config.max_velocity);
+        double velocity = std::copysign(speed, error);
+        if (config.max_acceleration > 0.0) {
+            const double dv = config.max_acceleration * dt;
+            velocity = std::clamp(velocity, state.velocity - dv, state.velocity + dv);
+        }
+        state.velocity = velocity;
+        state.position += velocity * dt;
+        return state.position;
+    }
+};
+
+struct Backlash {
+    static double apply(const AxisModelConfig & config, AxisModelState & state, double x, double) {
+        const double half = 0.5 * config.backlash;
+        if (x - state.play > half)
+            state.play = x - half;
+        else if (x - state.play < -half)
+            state.play = x + half;
+        return state.play;
+    }
+};
+
+// Approximately normal: sum of four xorshift64* uniforms
+struct Noise {
+    static double uniform(uint64_t & s) {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return static_cast<double>((s * 0x2545F4914F6CDD1DULL) >> 11) * 0x1.0p-53;
+    }
+    static double apply(const AxisModelConfig & config, AxisModelState & state, double x, double) {
+        const double sum = uniform(state.rng) + uniform(state.rng) + uniform(state.rng) + uniform(state.rng);
+        return x + config.noise * (sum - 2.0) * 1.7320508075688772;  // sqrt(12 / 4)
+    }
+};
+
+struct Quantization {
+    static double apply(const AxisModelConfig & config, AxisModelState &, double x, double) {
+        return std::nearbyint(x / config.resolution) * config.resolution;
+    }
+};
+
+template <bool Enabled, typename Policy>
+using Maybe = std::conditional_t<Enabled, Policy, Passthrough>;
+
+}  // namespace axis_policy
+
+// A stack of policies resolved at compile time, applied left to right.
+template <typename... Policies>
+struct AxisModel {
+    static double step(const AxisModelConfig & config, AxisModelState & state, double command, double dt) {
+        double x = command;
+        ((x = Policies::apply(config, state, x, dt)), ...);
+        return x;
+    }
+};
+
+// The stack for an AxisEffect mask: lag, saturation, backlash, noise, quantization.
+template <unsigned Effects>
+using AxisModelFor = AxisModel<
+    axis_policy::Maybe<(Effects & LAG) != 0, axis_policy::MotorLag>,
+    axis_policy::Maybe<(Effects & SATURATION) != 0, axis_policy::Saturation>,
+    axis_policy::Maybe<(Effects & BACKLASH) != 0, axis_policy::Backlash>,
+    axis_policy::Maybe<(Effects & NOISE) != 0, axis_policy::Noise>,
+    axis_policy::Maybe<(Effects & QUANTIZATION) != 0, axis_policy::Quantization>>;
+
+// Models of every axis of a fleet. Axes with the same effects are stepped
+// together by one instantiation of their stack, so the per-axis loop has
+// no indirect call; the effects are chosen once, at construction.
+class AxisModelBank {
+ public:
+    // One config and effect mask per axis, indexed like the motion engine.
+    AxisModelBank(const std::vector<AxisModelConfig> & configs, const std::vector<unsigned> & effects);
+
+    // Advance every axis by dt seconds towards command[i], its commanded position.
+    void step(const double * command, double dt);
+
+    // Back to the state at construction: at rest at 0, noise from the seeds.
+    void reset();
+
+    std::size_t size() const { return position.size(); }
+    double position_of(std::size_t i) const { return position[i]; }
+    double velocity_of(std::size_t i) const { return velocity[i]; }
+
+ private:
+    using StepFn = void (*)(const AxisModelConfig *, AxisModelState *, const std::size_t *,
+                            const double *, double *, double *, std::size_t, double);
+
+    struct Group {
+        StepFn step;
+        std::vector<std::size_t> axis;
+        std::vector<AxisModelConfig> config;
+        std::vector<AxisModelState> state;
+    };
+
+    std::vector<Group> groups;
+    std::vector<double> position;
+    std::vector<double> velocity;
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__AXIS_MODEL_HPP_
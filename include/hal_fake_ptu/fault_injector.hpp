@@ -0,0 +1,83 @@
+#ifndef HAL_FAKE_PTU__FAULT_INJECTOR_HPP_
+#define HAL_FAKE_PTU__FAULT_INJECTOR_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hal_fake_ptu {
+
+enum class LatencyDistribution { CONSTANT, UNIFORM, NORMAL, EXPONENTIAL, LOGNORMAL };
+
+// Parses "constant", "uniform", "normal", "exponential" or "lognormal",
+// throws std::invalid_argument otherwise.
+LatencyDistribution latency_distribution_from_string(const std::string & name);
+
+// What goes wrong on one command interface. Probabilities are per event.
+struct FaultConfig {
+    LatencyDistribution distribution = LatencyDistribution::CONSTANT;
+    double latency = 0.0;        // mean delay of responses and results, seconds
+    double jitter = 0.0;         // uniform half width, normal or lognormal standard deviation
+    double drop_feedback = 0.0;  // feedback message lost
+    double late_feedback = 0.0;  // feedback message delayed by a latency draw
+    double reject = 0.0;         // goal refused outright
+    std::size_t max_in_flight = 0;  // goals refused while this many are unfinished, 0 = no limit
+    double stall = 0.0;          // move brakes to a stop on its own and ends aborted...
+    double stall_after = 1.0;    // ...uniformly within this long after its start, seconds
+};
+
+// Seeded fault draws for a set of interfaces, indexed from 0. Each interface
+// draws from its own counter-based stream, so the sequence one of them sees
+// depends only on the seed and its own traffic. Lock-free; configure before use.
+class FaultInjector {
+ public:
+    FaultInjector(std::size_t interfaces, uint64_t seed);
+
+    void configure(std::size_t interface, const FaultConfig & config);
+
+    // State publications: each one starts a gap of duration_ns with this probability.
+    void configure_gaps(double probability, int64_t duration_ns);
+
+    // Whether the interface has any fault configured.
+    bool enabled(std::size_t interface) const;
+
+    // Delay of a response, >= 0.
+    int64_t latency_ns(std::size_t interface);
+
+    bool drop_feedback(std::size_t interface);
+    bool late_feedback(std::size_t interface);
+
+    // Whether a new goal gets through; counted in flight until release().
+    bool admit(std::size_t interface);
+    void release(std::size_t interface);
+
+    // When the move stalls after its start, < 0 for never.
+    int64_t stall_ns(std::size_t interface);
+
+    // Whether the state publication at stamp_ns falls in a gap. Calls must not run concurrently.
+    bool in_gap(int64_t stamp_ns);
+
+ private:
+    uint64_t next(std::size_t stream);
+    double uniform(std::size_t stream);
+    double normal(std::size_t stream);
+
+    const std::size_t interfaces;
+    const uint64_t seed;
+    std::vector<FaultConfig> config;
+    std::vector<uint8_t> active;
+    // One per interface, and one more for the state gaps
+    std::unique_ptr<std::atomic<uint64_t>[]> draws;
+    std::unique_ptr<std::atomic<int64_t>[]> in_flight;
+
+    double gap_probability = 0.0;
+    int64_t gap_duration_ns = 0;
+    int64_t gap_end_ns = 0;
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__FAULT_INJECTOR_HPP_
@@ -0,0 +1,65 @@
+#ifndef HAL_FAKE_PTU__GOAL_SCHEDULER_HPP_
+#define HAL_FAKE_PTU__GOAL_SCHEDULER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include "hal_fake_ptu/motion_engine.hpp"
+
+namespace hal_fake_ptu {
+
+// What happens to a command whose axes are already moving.
+enum class SchedulingPolicy {
+    PREEMPT,  // abort the running command and start the new one
+    QUEUE,    // run it after the running one, up to max_queued commands
+    REJECT    // refuse it
+};
+
+// Parses "preempt", "queue" or "reject", throws std::invalid_argument otherwise.
+SchedulingPolicy scheduling_policy_from_string(const std::string & name);
+
+// Per-axis admission in front of the motion engine. Holds no thread of its
+// own: queued commands are dispatched from the engine tick when the axes
+// they need are released.
+class GoalScheduler {
+ public:
+    GoalScheduler(MotionEngine & engine, SchedulingPolicy policy, std::size_t max_queued);
+
+    // Whether a command on these axes would be accepted right now.
+    bool admit(const std::array<bool, AXIS_COUNT> & axes) const;
+
+    // Dispatch, queue or reject (on_done(ABORTED)) the command.
+    void submit(MoveCommand && command);
+
+    // A move that is not a goal (service, serial port), posted to the engine
+    // at once whatever the policy. It supersedes the goals running on its
+    // axes, and queued goals on them wait until it ends.
+    void post(MoveCommand && command);
+
+    // Drop queued commands whose goal is being canceled; call once per tick.
+    void poll();
+
+    // Abort every queued command.
+    void clear();
+
+ private:
+    bool busy(const std::array<bool, AXIS_COUNT> & axes) const;
+    void dispatch(MoveCommand && command);
+    void release(const std::array<bool, AXIS_COUNT> & axes, std::array<int, AXIS_COUNT> & counts);
+
+    MotionEngine & engine;
+    const SchedulingPolicy policy;
+    const std::size_t max_queued;
+
+    mutable std::mutex mutex;
+    std::array<int, AXIS_COUNT> running{{0, 0}};
+    std::array<int, AXIS_COUNT> posted{{0, 0}};
+    std::deque<MoveCommand> queue;
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__GOAL_SCHEDULER_HPP_
@@ -0,0 +1,16 @@
+#ifndef HAL_FAKE_PTU__HAL_FAKE_PTU_HPP_
+#define HAL_FAKE_PTU__HAL_FAKE_PTU_HPP_
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+
+namespace hal_fake_ptu {
+
+// The simulator node, also registered as the "HALFakePTU" component. It is a
+// lifecycle node, configured and activated here unless lifecycle.autostart is
+// false. Throws std::runtime_error when its parameters are invalid.
+rclcpp_lifecycle::LifecycleNode::SharedPtr make_node(const rclcpp::NodeOptions & options);
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__HAL_FAKE_PTU_HPP_
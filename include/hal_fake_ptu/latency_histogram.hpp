@@ -0,0 +1,46 @@
+#ifndef HAL_FAKE_PTU__LATENCY_HISTOGRAM_HPP_
+#define HAL_FAKE_PTU__LATENCY_HISTOGRAM_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace hal_fake_ptu {
+
+// Counts of one histogram window, taken by LatencyHistogram::collect().
+struct LatencySummary {
+    uint64_t count = 0;
+    int64_t p50_ns = 0;
+    int64_t p99_ns = 0;
+    int64_t max_ns = 0;
+};
+
+// HDR-style log-linear histogram of nanosecond latencies: every power of two
+// is split in 2^SUB_BITS buckets, so a value is reported within about 3%.
+// record() is lock-free and wait-free apart from the max update, and may
+// be called from any number of threads.
+class LatencyHistogram {
+ public:
+    void record(int64_t ns);
+
+    // Summary of everything recorded since the previous collect(), which
+    // starts a new window. Values recorded meanwhile land in either window.
+    LatencySummary collect();
+
+ private:
+    static constexpr int SUB_BITS = 5;
+    static constexpr int64_t SUB_COUNT = int64_t{1} << SUB_BITS;
+    static constexpr int MAX_BITS = 40;  // ~18 minutes, larger values are clamped
+    static constexpr std::size_t BUCKETS = (MAX_BITS - SUB_BITS + 1) * SUB_COUNT;
+
+    static std::size_t bucket_of(int64_t ns);
+    static int64_t upper_bound_of(std::size_t bucket);
+
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+    std::atomic<int64_t> max{0};
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__LATENCY_HISTOGRAM_HPP_
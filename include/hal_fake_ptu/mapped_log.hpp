@@ -0,0 +1,67 @@
+#ifndef HAL_FAKE_PTU__MAPPED_LOG_HPP_
+#define HAL_FAKE_PTU__MAPPED_LOG_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "hal_fake_ptu/trace_buffer.hpp"
+
+namespace hal_fake_ptu {
+
+// Append-only file of TraceRecords, memory-mapped and sized up front so an
+// append is one atomic increment and a 32-byte copy: no lock, allocation,
+// formatting or system call. The file layout is the one of trace dumps, so
+// the same readers work on both. The header count is written at each
+// checkpoint() and on close, so a log whose process died keeps the records
+// up to the last checkpoint.
+class MappedLog {
+ public:
+    // New log at path with room for capacity records, replacing any file
+    // there. Throws std::system_error.
+    static std::unique_ptr<MappedLog> create(const std::string & path, std::size_t capacity);
+
+    // Existing log or trace dump, read only. Throws std::system_error, or
+    // std::runtime_error when the file is not one.
+    static std::unique_ptr<MappedLog> open(const std::string & path);
+
+    ~MappedLog();
+
+    MappedLog(const MappedLog &) = delete;
+    MappedLog & operator=(const MappedLog &) = delete;
+
+    // Safe from any number of threads; false (and counted) once full.
+    bool append(const TraceRecord & record);
+
+    // Publishes the count of records appended so far in the file header.
+    // A plain store to the mapping, which outlives the process: call it from
+    // one thread, e.g. after each engine tick. Appends still in flight on
+    // other threads may be counted before their record is written.
+    void checkpoint();
+
+    // Records appended so far, or in the file when opened.
+    std::size_t size() const;
+    const TraceRecord & operator[](std::size_t i) const { return records[i]; }
+
+    uint64_t dropped() const { return overflow.load(std::memory_order_relaxed); }
+
+ private:
+    MappedLog(int fd, void * base, std::size_t bytes, std::size_t capacity, bool writable);
+
+    const int fd;
+    void * const base;
+    const std::size_t bytes;
+    const std::size_t capacity;
+    const bool writable;
+
+    TraceBuffer::TraceFileHeader * header;
+    TraceRecord * records;
+    std::atomic<std::size_t> next{0};
+    std::atomic<uint64_t> overflow{0};
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__MAPPED_LOG_HPP_
@@ -0,0 +1,207 @@
+#ifndef HAL_FAKE_PTU__MOTION_ENGINE_HPP_
+#define HAL_FAKE_PTU__MOTION_ENGINE_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "hal_fake_ptu/seqlock.hpp"
+#include "hal_fake_ptu/trajectory.hpp"
+
+namespace hal_fake_ptu {
+
+enum Axis { PAN = 0, TILT = 1, AXIS_COUNT = 2 };
+
+enum class MoveStatus { SUCCEEDED, CANCELED, ABORTED };
+
+using AxisValues = std::array<double, AXIS_COUNT>;
+
+// One point of a multi-segment move.
+struct Waypoint {
+    AxisValues target{{0.0, 0.0}};
+    AxisValues max_velocity{{0.0, 0.0}};  // cap below the axis limit, <= 0 = none
+    int64_t duration_ns = 0;              // reach it this long after the previous one, 0 = asap
+};
+
+// A move posted to the engine by a service or an action goal.
+// Callbacks are always invoked from the engine tick, outside the engine lock.
+struct MoveCommand {
+    std::size_t unit = 0;
+    std::array<bool, AXIS_COUNT> active{{false, false}};
+    AxisValues target{{0.0, 0.0}};
+
+    // When not empty, followed in order instead of target. Within blend of a
+    // waypoint the axes head on to the next one without stopping.
+    std::vector<Waypoint> waypoints;
+    double blend = 0.0;
+
+    // Polled every tick, returning true stops the axes where they are.
+    std::function<bool()> is_canceling;
+    // Called once from the tick that starts the move, before any progress.
+    std::function<void()> on_start;
+    // Completion percentage of every axis, once per tick while moving.
+    std::function<void(const AxisValues &)> on_progress;
+    // Index of the waypoint now headed to, each time it changes after the first.
+    std::function<void(std::size_t)> on_segment;
+    // Called exactly once when the move ends.
+    std::function<void(MoveStatus)> on_done;
+};
+
+// Consistent view of both axes at one instant.
+struct PTUState {
+    AxisValues position{{0.0, 0.0}};
+    AxisValues velocity{{0.0, 0.0}};
+    AxisValues speed{{0.0, 0.0}};
+    std::array<bool, AXIS_COUNT> moving{{false, false}};
+    int64_t stamp_ns = 0;
+};
+
+struct AxisConfig {
+    double speed;         // maximum velocity
+    double acceleration;  // maximum acceleration
+    double threshold;     // smaller excursions are not moved at all
+};
+
+// Owns the axis state of one or more identical pan-tilt units. Every move
+// is planned once as a trapezoidal profile per axis; the fixed-rate tick
+// only adopts new commands and reports progress and completion, the
+// positions themselves are closed form. Per-axis state is kept in flat
+// arrays indexed by unit * AXIS_COUNT + axis, so one tick scans a whole
+// fleet with a single pass over contiguous memory.
+class MotionEngine {
+ public:
+    MotionEngine(std::size_t units, const std::array<AxisConfig, AXIS_COUNT> & axes);
+
+    std::size_t units() const { return unit_count; }
+
+    // Queue a move; it is picked up at the next tick and supersedes
+    // (aborts) any move still running on the same axes of the same unit.
+    void post(MoveCommand && command);
+
+    // Start posted moves at stamp_ns and settle the ones that ended by then.
+    // Returns right away when nothing is pending or moving. Called from one
+    // thread at a time.
+    void tick(int64_t stamp_ns);
+
+    // Latest-value-wins setpoint: the axis heads to target at no more than
+    // max_velocity (and the axis limits) from the next tick on, aborting the
+    // move running there. max_velocity <= 0 brakes to a stop. Lock-free;
+    // calls for the same axis must not run concurrently.
+    void set_setpoint(std::size_t unit, Axis axis, double target, double max_velocity);
+
+    // Abort every move of the unit and bring both its axes back to zero.
+    void reset(std::size_t unit);
+
+    // Moves in progress on this axis are replanned at the next tick.
+    void set_speed(std::size_t unit, Axis axis, double speed);
+
+    // New limits for every axis of every unit, taken over as a whole at the
+    // next tick; moves in progress are replanned from where they are. Replaces
+    // speeds set with set_speed. Lock-free; calls must not run concurrently.
+    void configure(const std::array<AxisConfig, AXIS_COUNT> & axes);
+
+    // State as of the last change to the unit's plan. Lock-free, never
+    // blocks on the engine tick. Version increases with every change.
+    PTUState snapshot(std::size_t unit, uint64_t * version = nullptr) const;
+
+    // State evaluated from the unit's current plan at any stamp_ns, past or future.
+    PTUState sample(std::size_t unit, int64_t stamp_ns) const;
+
+    // sample() at each of count stamps into out, all from the same plan.
+    // Returns when that plan comes to rest. Lock-free.
+    int64_t predict(std::size_t unit, const int64_t * stamps, std::size_t count, PTUState * out) const;
+
+ private:
+    struct Move {
+        MoveCommand command;
+        std::size_t segment = 0;
+        AxisValues excursion{{0.0, 0.0}};
+        std::array<bool, AXIS_COUNT> reached{{true, true}};
+
+        const Waypoint & waypoint() const { return command.waypoints[segment]; }
+        bool last_segment() const { return segment + 1 >= command.waypoints.size(); }
+    };
+
+    // What readers need to evaluate a unit without the engine lock
+    struct Plan {
+        std::array<TrapezoidalProfile, AXIS_COUNT> profile;
+        AxisValues speed{{0.0, 0.0}};
+        int64_t stamp_ns = 0;
+    };
+
+    struct Setpoint {
+        double target = 0.0;
+        double max_velocity = 0.0;
+    };
+
+    struct Event {
+        enum Kind { STARTED, PROGRESS, SEGMENT, DONE };
+
+        std::shared_ptr<Move> move;
+        Kind kind;
+        MoveStatus status;
+        AxisValues progress;
+        std::size_t segment = 0;
+    };
+
+    static std::size_t index(std::size_t unit, int axis) { return unit * AXIS_COUNT + axis; }
+
+    void adopt(const std::shared_ptr<Move> & move, std::vector<Event> & events);
+    void plan_segment(Move & move, int64_t stamp_ns);
+    bool within_blend(const Move & move, int64_t stamp_ns) const;
+    void apply_setpoints(std::vector<Event> & events);
+    void apply_config();
+    void release(const std::shared_ptr<Move> & move);
+    void set_profile(std::size_t i, const TrapezoidalProfile & next);
+    AxisValues progress_of(const Move & move, int64_t stamp_ns) const;
+    AxisLimits limits_of(std::size_t i) const;
+    void publish_state(std::size_t unit);
+    static PTUState evaluate(const Plan & plan, int64_t stamp_ns);
+
+    const std::size_t unit_count;
+    const std::size_t axis_count;
+
+    mutable std::mutex mutex;
+
+    // One entry per axis of every unit
+    std::vector<double> max_velocity;
+    std::vector<double> max_acceleration;
+    std::vector<double> threshold;
+    std::vector<TrapezoidalProfile> profile;
+    std::vector<int64_t> end_ns;         // profile[i].end(), scanned every tick
+    std::vector<uint8_t> settling;       // owned by a move still heading to its target
+    std::vector<uint8_t> arrived;        // scratch for the tick
+    std::vector<uint8_t> replan;
+    std::vector<std::shared_ptr<Move>> owner;
+    std::vector<uint64_t> setpoint_seen;  // last mailbox version applied
+    bool replan_pending = false;
+
+    // One entry per unit
+    std::vector<uint8_t> dirty;
+
+    std::vector<std::shared_ptr<Move>> pending;
+    std::vector<std::shared_ptr<Move>> moves;
+    int64_t last_stamp_ns = 0;
+
+    // Scratch for the tick, kept for their capacity
+    std::vector<std::shared_ptr<Move>> running;
+    std::vector<Event> tick_events;
+
+    // Written only with the mutex held, read without it
+    std::unique_ptr<SeqLock<Plan>[]> state;
+
+    // Written without the mutex, read by the tick
+    std::unique_ptr<SeqLock<Setpoint>[]> setpoint;
+    std::atomic<bool> setpoints_pending{false};
+    SeqLock<std::array<AxisConfig, AXIS_COUNT>> config;
+    std::atomic<bool> config_pending{false};
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__MOTION_ENGINE_HPP_
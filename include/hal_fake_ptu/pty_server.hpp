@@ -0,0 +1,74 @@
+#ifndef HAL_FAKE_PTU__PTY_SERVER_HPP_
+#define HAL_FAKE_PTU__PTY_SERVER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "hal_fake_ptu/serial_protocol.hpp"
+
+namespace hal_fake_ptu {
+
+// Serves a SerialProtocol on a pseudo-terminal, so a serial driver can
+// open the slave side as if it were the unit's port. One thread runs a
+// non-blocking epoll loop: bytes are parsed straight from the receive
+// buffer, responses go out as the port accepts them, and reading pauses
+// while responses are backed up.
+class PtyServer {
+ public:
+    // Opens the pty in raw mode; with link not empty, a symlink to the slave
+    // device is (re)created there. While an A is pending, moves are checked
+    // every poll_ns. Throws std::system_error when the pty cannot be set up.
+    PtyServer(SerialProtocol & protocol, const std::string & link = "", int64_t poll_ns = 1000000);
+    ~PtyServer();
+
+    PtyServer(const PtyServer &) = delete;
+    PtyServer & operator=(const PtyServer &) = delete;
+
+    // Slave device path, e.g. /dev/pts/3
+    const std::string & device() const { return slave_name; }
+
+    void start();
+
+    // Returns after the loop iteration in progress.
+    void stop();
+
+    // Bytes received since the start.
+    uint64_t received() const { return bytes_in.load(std::memory_order_relaxed); }
+
+    static constexpr std::size_t BUFFER_SIZE = 4096;
+
+ private:
+    void run();
+    void read_input();
+    void process();
+    void flush();
+    void watch(uint32_t events);
+
+    SerialProtocol & protocol;
+    const std::string link;
+    const int poll_ms;
+
+    int master = -1;
+    int slave = -1;  // kept open, so the master does not hang up between clients
+    int epoll = -1;
+    int wake = -1;
+    std::string slave_name;
+
+    std::array<char, BUFFER_SIZE> input;
+    std::size_t filled = 0;
+    std::string output;
+    std::size_t written = 0;
+    uint32_t watched = 0;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> bytes_in{0};
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__PTY_SERVER_HPP_
@@ -0,0 +1,69 @@
+#ifndef HAL_FAKE_PTU__SEQLOCK_HPP_
+#define HAL_FAKE_PTU__SEQLOCK_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace hal_fake_ptu {
+
+// Versioned value with a single (or externally serialized) writer and any
+// number of wait-free-on-the-writer, lock-free readers. The payload is copied
+// through relaxed atomic words so concurrent reads are well defined.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+ public:
+    SeqLock() { store(T{}); }
+
+    void store(const T & value) {
+        uint64_t words_in[WORDS] = {};
+        std::memcpy(words_in, &value, sizeof(T));
+
+        uint64_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (std::size_t i = 0; i < WORDS; i++)
+            words[i].store(words_in[i], std::memory_order_relaxed);
+
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Returns the latest complete value, retrying while a write is in progress.
+    T load(uint64_t * version = nullptr) const {
+        uint64_t words_out[WORDS];
+        uint64_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < WORDS; i++)
+                words_out[i] = words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) or before != after);
+
+        if (version)
+            *version = before / 2;
+
+        T value;
+        std::memcpy(&value, words_out, sizeof(T));
+        return value;
+    }
+
+    uint64_t version() const {
+        return sequence.load(std::memory_order_acquire) / 2;
+    }
+
+ private:
+    static constexpr std::size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence{0};
+    std::array<std::atomic<uint64_t>, WORDS> words{};
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__SEQLOCK_HPP_
@@ -0,0 +1,72 @@
+#ifndef HAL_FAKE_PTU__SERIAL_PROTOCOL_HPP_
+#define HAL_FAKE_PTU__SERIAL_PROTOCOL_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "hal_fake_ptu/motion_engine.hpp"
+
+namespace hal_fake_ptu {
+
+// What the serial front end drives. Called from the serial I/O thread.
+struct SerialHandlers {
+    std::function<PTUState()> state;
+    std::function<std::pair<double, double>(Axis)> range;  // min, max position
+    // Head to a position; settled must be called once when that move ends, however it ends
+    std::function<void(Axis, double, std::function<void()> settled)> move;
+    std::function<void(Axis, double)> set_speed;
+    std::function<void(Axis)> halt;                        // brake where the axis is
+    std::function<void()> reset;
+};
+
+// Terse ASCII pan-tilt protocol in the style of the classic PTU-D46 units.
+// Commands are separated by whitespace, so any number of them can be
+// pipelined on one line; each gets exactly one response line, in order:
+//   "*" done, "* <value>" for a query, "! <reason>" on an error.
+// Positions are in steps of resolution axis units, speeds in steps/s.
+//
+//   PP[<n>] TP[<n>]   query / set the pan or tilt position
+//   PS[<n>] TS[<n>]   query / set the pan or tilt speed
+//   PN PX TN TX       minimum and maximum positions
+//   PR TR             resolution, arc seconds per step
+//   H HP HT           halt both axes, pan or tilt
+//   R                 reset to zero
+//   A                 await: answered once the moves commanded here ended
+//                     and both axes stopped; the commands after it run only then
+class SerialProtocol {
+ public:
+    SerialProtocol(SerialHandlers handlers, double resolution);
+
+    // Runs every complete command at the start of input, appending the
+    // responses to output. Returns the bytes consumed, which stops short
+    // of an incomplete last command and of anything after a pending A.
+    // Commands are parsed in place, nothing is copied.
+    std::size_t execute(std::string_view input, std::string & output);
+
+    bool awaiting() const { return await_pending; }
+
+    // Answers a pending A once its moves ended; true if it did.
+    bool poll(std::string & output);
+
+    static constexpr std::size_t MAX_COMMAND = 32;
+
+ private:
+    void run(std::string_view command, std::string & output);
+    void position(Axis axis, std::string_view argument, std::string & output);
+    void speed(Axis axis, std::string_view argument, std::string & output);
+    void reply(std::string & output, long value) const;
+    void reply(std::string & output, double value) const;
+
+    SerialHandlers handlers;
+    double resolution;
+    bool await_pending = false;
+    std::atomic<int> in_flight{0};  // moves not settled yet
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__SERIAL_PROTOCOL_HPP_
@@ -0,0 +1,120 @@
+#ifndef HAL_FAKE_PTU__SHARED_STATE_HPP_
+#define HAL_FAKE_PTU__SHARED_STATE_HPP_
+
+// Layout of the POSIX shared-memory segment the simulator mirrors its axis
+// state into, and a reader for it. Header only, no ROS: a consumer includes
+// this and seqlock.hpp and links nothing. Both sides must run on the same
+// architecture.
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include "hal_fake_ptu/seqlock.hpp"
+
+namespace hal_fake_ptu {
+
+// One unit as of an engine tick, pan first then tilt.
+struct SharedPose {
+    int64_t stamp_ns = 0;  // engine time of the sample, ROS time (system clock unless simulated)
+    std::array<double, 2> position{{0.0, 0.0}};
+    std::array<double, 2> velocity{{0.0, 0.0}};
+    std::array<uint8_t, 2> moving{{0, 0}};
+
+    // Linear extrapolation to at_ns, for sampling between ticks
+    std::array<double, 2> position_at(int64_t at_ns) const {
+        const double dt = (at_ns - stamp_ns) * 1e-9;
+        return {{position[0] + velocity[0] * dt, position[1] + velocity[1] * dt}};
+    }
+};
+
+constexpr char SHARED_STATE_MAGIC[8] = {'P', 'T', 'U', 'S', 'T', 'A', 'T', 'E'};
+constexpr uint32_t SHARED_STATE_VERSION = 1;
+
+// magic is written last, so a segment with it is fully initialized
+struct SharedStateHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t units;
+    uint64_t slot_bytes;
+};
+
+// A cache line per unit, so writes to one never disturb readers of another
+struct alignas(64) SharedStateSlot {
+    SeqLock<SharedPose> pose;
+};
+
+static_assert(sizeof(SharedStateHeader) <= sizeof(SharedStateSlot), "the header must fit in a slot");
+
+constexpr std::size_t shared_state_bytes(std::size_t units) {
+    return sizeof(SharedStateSlot) * (units + 1);  // the header takes the first slot
+}
+
+
+// Read-only view of a segment. read() never blocks the simulator and takes
+// well under a microsecond: it retries only while that unit is being written.
+class SharedStateReader {
+ public:
+    // name as given to the simulator, e.g. "/hal_fake_ptu_state". Throws
+    // std::system_error, or std::runtime_error when the segment is not one.
+    static std::unique_ptr<SharedStateReader> open(const std::string & name) {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), name);
+        struct stat info;
+        if (fstat(fd, &info) != 0 or static_cast<std::size_t>(info.st_size) < shared_state_bytes(0)) {
+            ::close(fd);
+            throw std::runtime_error(name + " is not a PTU state segment");
+        }
+        const std::size_t bytes = static_cast<std::size_t>(info.st_size);
+        void * base = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED)
+            throw std::system_error(errno, std::generic_category(), name);
+
+        const auto * header = static_cast<const SharedStateHeader *>(base);
+        if (std::memcmp(header->magic, SHARED_STATE_MAGIC, sizeof(SHARED_STATE_MAGIC)) != 0 or
+            header->version != SHARED_STATE_VERSION or header->slot_bytes != sizeof(SharedStateSlot) or
+            bytes < shared_state_bytes(header->units)) {
+            munmap(base, bytes);
+            throw std::runtime_error(name + " is not a PTU state segment");
+        }
+        return std::unique_ptr<SharedStateReader>(new SharedStateReader(base, bytes));
+    }
+
+    ~SharedStateReader() { munmap(base, bytes); }
+
+    SharedStateReader(const SharedStateReader &) = delete;
+    SharedStateReader & operator=(const SharedStateReader &) = delete;
+
+    std::size_t units() const { return header().units; }
+
+    // Latest pose of the unit; sequence, when given, counts its updates.
+    SharedPose read(std::size_t unit, uint64_t * sequence = nullptr) const {
+        return slots()[unit].pose.load(sequence);
+    }
+
+ private:
+    SharedStateReader(void * base, std::size_t bytes) : base(base), bytes(bytes) {}
+
+    const SharedStateHeader & header() const { return *static_cast<const SharedStateHeader *>(base); }
+    const SharedStateSlot * slots() const { return static_cast<const SharedStateSlot *>(base) + 1; }
+
+    void * const base;
+    const std::size_t bytes;
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__SHARED_STATE_HPP_
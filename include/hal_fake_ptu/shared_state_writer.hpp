@@ -0,0 +1,40 @@
+#ifndef HAL_FAKE_PTU__SHARED_STATE_WRITER_HPP_
+#define HAL_FAKE_PTU__SHARED_STATE_WRITER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "hal_fake_ptu/motion_engine.hpp"
+#include "hal_fake_ptu/shared_state.hpp"
+
+namespace hal_fake_ptu {
+
+// Simulator side of the shared state segment. The segment is removed when
+// the writer goes away; readers that still have it mapped keep the last poses.
+class SharedStateWriter {
+ public:
+    // Creates (or replaces) the named segment with one slot per unit.
+    // Throws std::system_error.
+    static std::unique_ptr<SharedStateWriter> create(const std::string & name, std::size_t units);
+
+    ~SharedStateWriter();
+
+    SharedStateWriter(const SharedStateWriter &) = delete;
+    SharedStateWriter & operator=(const SharedStateWriter &) = delete;
+
+    // Wait-free. Writes to the same unit must not run concurrently.
+    void write(std::size_t unit, const PTUState & state);
+
+ private:
+    SharedStateWriter(const std::string & name, void * base, std::size_t bytes);
+
+    const std::string name;
+    void * const base;
+    const std::size_t bytes;
+    SharedStateSlot * slots;
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__SHARED_STATE_WRITER_HPP_
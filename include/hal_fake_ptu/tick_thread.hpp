@@ -0,0 +1,70 @@
+#ifndef HAL_FAKE_PTU__TICK_THREAD_HPP_
+#define HAL_FAKE_PTU__TICK_THREAD_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hal_fake_ptu/latency_histogram.hpp"
+
+namespace hal_fake_ptu {
+
+struct TickThreadConfig {
+    int64_t period_ns = 10000000;
+    int cpu = -1;                  // pin to this CPU, -1 = any
+    std::string policy = "other";  // other, fifo or rr
+    int priority = 0;              // fifo and rr only
+    bool lock_memory = false;      // mlockall, so page faults cannot delay a tick
+};
+
+// Dedicated thread calling a function at absolute deadlines on the
+// monotonic clock, period_ns apart. Unlike a relative sleep, a late tick
+// does not shift the ones after it; when a tick overruns whole periods
+// those deadlines are skipped and counted instead of run back to back.
+class TickThread {
+ public:
+    // Throws std::invalid_argument on an unknown policy or a non-positive period.
+    TickThread(const TickThreadConfig & config, std::function<void()> tick);
+    ~TickThread();
+
+    TickThread(const TickThread &) = delete;
+    TickThread & operator=(const TickThread &) = delete;
+
+    // Starts ticking. Returns what could not be applied (e.g. SCHED_FIFO
+    // without the privilege); the thread runs anyway with what could.
+    std::vector<std::string> start();
+
+    // Returns after the tick in progress, if any.
+    void stop();
+
+    // Takes effect from the next deadline on. Throws std::invalid_argument
+    // on a non-positive period.
+    void set_period(int64_t period_ns);
+
+    // Deadlines skipped since the previous call.
+    uint64_t collect_missed() { return missed.exchange(0, std::memory_order_relaxed); }
+
+    // Wake-up delay past each deadline since the previous call.
+    LatencySummary collect_jitter() { return jitter.collect(); }
+
+ private:
+    void run();
+
+    const TickThreadConfig config;
+    int policy;
+    std::function<void()> tick;
+
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> released{false};
+    std::atomic<int64_t> period_ns;
+    std::atomic<uint64_t> missed{0};
+    LatencyHistogram jitter;
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__TICK_THREAD_HPP_
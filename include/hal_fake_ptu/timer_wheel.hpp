@@ -0,0 +1,62 @@
+#ifndef HAL_FAKE_PTU__TIMER_WHEEL_HPP_
+#define HAL_FAKE_PTU__TIMER_WHEEL_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace hal_fake_ptu {
+
+// Hashed timing wheel of callbacks due at a stamp, run from the engine tick.
+// Each slot holds the entries due within one resolution_ns; advance() only
+// visits the slots it steps over, so its cost does not grow with the number
+// of entries waiting elsewhere. Entries further out than the wheel spans wait
+// in their slot for as many turns as it takes.
+class TimerWheel {
+ public:
+    using Callback = std::function<void()>;
+
+    TimerWheel(int64_t resolution_ns, std::size_t slots = 1024);
+
+    TimerWheel(const TimerWheel &) = delete;
+    TimerWheel & operator=(const TimerWheel &) = delete;
+
+    // From any thread. Already due: runs at the next advance().
+    void schedule(int64_t due_ns, Callback callback);
+
+    // Runs every callback due by now_ns in due order, outside the lock, so
+    // they can schedule again. Calls must not run concurrently.
+    void advance(int64_t now_ns);
+
+    // Scheduled and not run yet.
+    std::size_t pending() const;
+
+    // From any thread, as the tick period changes. Pending entries move to
+    // their slot at the new resolution and keep their due stamps.
+    void set_resolution(int64_t resolution_ns);
+
+ private:
+    struct Entry {
+        int64_t due_ns;
+        Callback callback;
+    };
+
+    std::vector<Entry> & slot_of(int64_t tick) { return wheel[static_cast<std::size_t>(tick) % wheel.size()]; }
+
+    int64_t resolution_ns;
+
+    mutable std::mutex mutex;
+    std::vector<std::vector<Entry>> wheel;
+    // First tick not fully visited yet; none before the first advance()
+    int64_t cursor = std::numeric_limits<int64_t>::min();
+    std::size_t count = 0;
+
+    std::vector<Entry> due;  // scratch for advance()
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__TIMER_WHEEL_HPP_
@@ -0,0 +1,80 @@
+#ifndef HAL_FAKE_PTU__TRACE_BUFFER_HPP_
+#define HAL_FAKE_PTU__TRACE_BUFFER_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace hal_fake_ptu {
+
+enum class TraceEvent : uint16_t {
+    SAMPLE = 0,    // detail: axis, value: position, velocity
+    COMMAND = 1,   // detail: axis mask, value: targets
+    DONE = 2,      // detail: MoveStatus
+    SETPOINT = 3,  // detail: axis, value: target, max velocity
+    RESET = 4,
+    TICK = 5,      // engine tick done at stamp_ns
+    SPEED = 6,     // value: pan and tilt speed
+    CANCEL = 7,    // value: ordinal of the COMMAND being canceled
+    TRAJECTORY = 8,       // detail: waypoint count, value: blend; the waypoints and their COMMAND follow
+    WAYPOINT = 9,             // value: targets; its velocity and duration follow
+    WAYPOINT_VELOCITY = 10,   // value: pan and tilt velocity cap
+    WAYPOINT_DURATION = 11    // value: duration in seconds
+};
+
+// COMMAND detail bits besides the axis mask
+constexpr uint16_t TRACE_COMMAND_ACTION = 4;  // action goal, through the scheduler
+
+// Fixed-size binary record, written to dump files as is.
+struct TraceRecord {
+    int64_t stamp_ns;
+    uint32_t unit;
+    uint16_t event;
+    uint16_t detail;
+    double value[2];
+};
+
+// Preallocated ring of the latest trace records. Any number of threads
+// record concurrently without locks or allocation, the oldest records are
+// overwritten. Dump files start with TraceFileHeader followed by the
+// records, oldest first.
+class TraceBuffer {
+ public:
+    struct TraceFileHeader {
+        char magic[8];  // "PTUTRACE"
+        uint32_t version;
+        uint32_t record_size;
+        uint64_t count;
+    };
+
+    // Capacity is rounded up to a power of two; 0 disables tracing.
+    explicit TraceBuffer(std::size_t capacity);
+
+    bool enabled() const { return mask != SIZE_MAX; }
+
+    void record(TraceEvent event, int64_t stamp_ns, std::size_t unit, uint16_t detail,
+                double value0 = 0.0, double value1 = 0.0);
+
+    // Writes the records still in the ring; returns how many, or -1 on I/O error.
+    long dump(const std::string & path) const;
+
+ private:
+    static constexpr std::size_t WORDS = sizeof(TraceRecord) / sizeof(uint64_t);
+    static_assert(sizeof(TraceRecord) % sizeof(uint64_t) == 0, "TraceRecord must be a whole number of words");
+
+    // Sequence 2 * index + 2 once the record with that index is complete
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<uint64_t> words[WORDS];
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> head{0};
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__TRACE_BUFFER_HPP_
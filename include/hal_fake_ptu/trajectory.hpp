@@ -0,0 +1,73 @@
+#ifndef HAL_FAKE_PTU__TRAJECTORY_HPP_
+#define HAL_FAKE_PTU__TRAJECTORY_HPP_
+
+#include <array>
+#include <cstdint>
+
+namespace hal_fake_ptu {
+
+struct AxisLimits {
+    double max_velocity;
+    double max_acceleration;
+};
+
+struct TrajectorySample {
+    double position;
+    double velocity;
+};
+
+// Velocity-limited, acceleration-limited motion of one axis ending at rest,
+// planned once as a few constant-acceleration segments and evaluated in
+// closed form at any time. Trivially copyable so it can be published
+// through a SeqLock.
+class TrapezoidalProfile {
+ public:
+    // At rest at position 0 forever.
+    TrapezoidalProfile() = default;
+
+    // At rest at position from start_ns on.
+    static TrapezoidalProfile hold(double position, int64_t start_ns);
+
+    // From (position, velocity) at start_ns to rest at target. Starting
+    // towards the wrong direction or too fast to stop in time first brakes
+    // to rest, then comes back.
+    static TrapezoidalProfile plan(const TrajectorySample & start, double target,
+                                   const AxisLimits & limits, int64_t start_ns);
+
+    // From (position, velocity) at start_ns to rest as soon as possible.
+    static TrapezoidalProfile stop(const TrajectorySample & start, const AxisLimits & limits, int64_t start_ns);
+
+    TrajectorySample at(int64_t stamp_ns) const;
+
+    bool finished(int64_t stamp_ns) const { return stamp_ns >= end_ns; }
+    int64_t end() const { return end_ns; }
+    double target() const { return goal; }
+
+ private:
+    struct Segment {
+        double t0;  // seconds since start_ns
+        double p0;
+        double v0;
+        double a;
+    };
+
+    static constexpr int MAX_SEGMENTS = 4;
+
+    void append(double duration, double acceleration);
+    void close();
+
+    std::array<Segment, MAX_SEGMENTS> segments{};
+    int count = 0;
+    int64_t start_ns = 0;
+    int64_t end_ns = 0;
+    double goal = 0.0;
+
+    // End of the last appended segment while planning
+    double t_end = 0.0;
+    double p_end = 0.0;
+    double v_end = 0.0;
+};
+
+}  // namespace hal_fake_ptu
+
+#endif  // HAL_FAKE_PTU__TRAJECTORY_HPP_
@@ -9,6 +9,8 @@ import pathlib
 import launch.actions
 from launch.actions import DeclareLaunchArgument
 from launch_ros.actions import Node
+from launch_ros.parameter_descriptions import ParameterValue
+from launch.substitutions import LaunchConfiguration
 
 from launch.actions.execute_process import ExecuteProcess
 
@@ -16,7 +18,23 @@ def generate_launch_description():
 
     params = os.path.join(get_package_share_directory("hal_fake_ptu"), 'params', 'params.yaml')
     
+    # Executor of the standalone node: multi_threaded (executor_threads, 0 = one
+    # per core), single_threaded, static_single_threaded or events
+    executor = {
+        'executor.type': LaunchConfiguration('executor_type'),
+        'executor.threads': ParameterValue(LaunchConfiguration('executor_threads'), value_type=int),
+    }
+
+    # autostart:=false leaves the node unconfigured for a lifecycle manager
+    lifecycle = {
+        'lifecycle.autostart': ParameterValue(LaunchConfiguration('autostart'), value_type=bool),
+    }
+
     return LaunchDescription([
+
+        DeclareLaunchArgument('executor_type', default_value='multi_threaded'),
+        DeclareLaunchArgument('executor_threads', default_value='0'),
+        DeclareLaunchArgument('autostart', default_value='true'),
         
         Node(
             package='hal_fake_ptu',
@@ -26,6 +44,6 @@ def generate_launch_description():
                     "stdout": "screen",
                     "stderr": "screen",
             },
-            parameters=[params],
+            parameters=[params, executor, lifecycle],
         )
 ])
\ No newline at end of file
@@ -0,0 +1,32 @@
+from launch import LaunchDescription
+from ament_index_python.packages import get_package_share_directory
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.descriptions import ComposableNode
+import os
+
+
+def generate_launch_description():
+
+    params = os.path.join(get_package_share_directory("hal_fake_ptu"), 'params', 'params.yaml')
+
+    # Load further components (e.g. camera fusion) into the same container to
+    # receive /ptu/state through intra-process communication, without copies.
+    return LaunchDescription([
+
+        ComposableNodeContainer(
+            name='hal_fake_ptu_container',
+            namespace='',
+            package='rclcpp_components',
+            executable='component_container_mt',
+            output='screen',
+            composable_node_descriptions=[
+                ComposableNode(
+                    package='hal_fake_ptu',
+                    plugin='HALFakePTU',
+                    name='hal_fake_ptu',
+                    parameters=[params],
+                    extra_arguments=[{'use_intra_process_comms': True}],
+                ),
+            ],
+        )
+])
@@ -0,0 +1,102 @@
+#include "hal_fake_ptu/axis_model.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <utility>
+
+namespace hal_fake_ptu {
+
+namespace {
+
+template <unsigned Effects>
+void step_group(const AxisModelConfig * config, AxisModelState * state, const std::size_t * axis,
+                const double * command, double * position, double * velocity, std::size_t count, double dt) {
+    using Model = AxisModelFor<Effects>;
+    const double rate = dt > 0.0 ? 1.0 / dt : 0.0;
+    for (std::size_t k = 0; k < count; k++) {
+        const std::size_t i = axis[k];
+        const double x = Model::step(config[k], state[k], command[i], dt);
+        velocity[i] = (x - position[i]) * rate;
+        position[i] = x;
+    }
+}
+
+template <std::size_t... Effects>
+constexpr auto make_step_table(std::index_sequence<Effects...>) {
+    using StepFn = void (*)(const AxisModelConfig *, AxisModelState *, const std::size_t *,
+                            const double *, double *, double *, std::size_t, double);
+    return std::array<StepFn, sizeof...(Effects)>{{&step_group<Effects>...}};
+}
+
+// Every stack instantiated once, looked up by effect mask
+constexpr auto step_table = make_step_table(std::make_index_sequence<AXIS_EFFECT_MASK + 1>());
+
+AxisModelState initial_state(const AxisModelConfig & config) {
+    AxisModelState state;
+    // splitmix64 of the seed: never zero, distinct streams for close seeds
+    uint64_t z = config.seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    state.rng = (z ^ (z >> 31)) | 1;
+    return state;
+}
+
+}  // namespace
+
+
+unsigned axis_effects_from_strings(const std::vector<std::string> & names) {
+    unsigned effects = 0;
+    for (const std::string & name : names) {
+        if (name == "lag")
+            effects |= LAG;
+        else if (name == "saturation")
+            effects |= SATURATION;
+        else if (name == "backlash")
+            effects |= BACKLASH;
+        else if (name == "noise")
+            effects |= NOISE;
+        else if (name == "quantization")
+            effects |= QUANTIZATION;
+        else
+            throw std::invalid_argument("unknown axis effect '" + name + "'");
+    }
+    return effects;
+}
+
+
+AxisModelBank::AxisModelBank(const std::vector<AxisModelConfig> & configs, const std::vector<unsigned> & effects)
+    : position(configs.size(), 0.0), velocity(configs.size(), 0.0) {
+    for (std::size_t i = 0; i < configs.size(); i++) {
+        unsigned mask = effects[i] & AXIS_EFFECT_MASK;
+        // Quantizing to a zero step would divide by zero
+        if (configs[i].resolution <= 0.0)
+            mask &= ~static_cast<unsigned>(QUANTIZATION);
+
+        auto group = std::find_if(groups.begin(), groups.end(), [mask](const Group & g) { return g.step == step_table[mask]; });
+        if (group == groups.end())
+            group = groups.insert(groups.end(), Group{step_table[mask], {}, {}, {}});
+
+        group->axis.push_back(i);
+        group->config.push_back(configs[i]);
+        group->state.push_back(initial_state(configs[i]));
+    }
+}
+
+
+void AxisModelBank::step(const double * command, double dt) {
+    for (Group & group : groups)
+        group.step(group.config.data(), group.state.data(), group.axis.data(), command,
+                   position.data(), velocity.data(), group.axis.size(), dt);
+}
+
+
+void AxisModelBank::reset() {
+    for (Group & group : groups) {
+        for (std::size_t k = 0; k < group.state.size(); k++)
+            group.state[k] = initial_state(group.config[k]);
+    }
+    std::fill(position.begin(), position.end(), 0.0);
+    std::fill(velocity.begin(), velocity.end(), 0.0);
+}
+
+}  // namespace hal_fake_ptu
@@ -0,0 +1,146 @@
+#include "hal_fake_ptu/fault_injector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace hal_fake_ptu {
+
+LatencyDistribution latency_distribution_from_string(const std::string & name) {
+    if (name == "constant")
+        return LatencyDistribution::CONSTANT;
+    if (name == "uniform")
+        return LatencyDistribution::UNIFORM;
+    if (name == "normal")
+        return LatencyDistribution::NORMAL;
+    if (name == "exponential")
+        return LatencyDistribution::EXPONENTIAL;
+    if (name == "lognormal")
+        return LatencyDistribution::LOGNORMAL;
+    throw std::invalid_argument("unknown latency distribution '" + name + "'");
+}
+
+
+FaultInjector::FaultInjector(std::size_t interfaces, uint64_t seed)
+    : interfaces(interfaces), seed(seed), config(interfaces), active(interfaces, 0),
+      draws(new std::atomic<uint64_t>[interfaces + 1]), in_flight(new std::atomic<int64_t>[interfaces]) {
+    for (std::size_t i = 0; i <= interfaces; i++)
+        draws[i].store(0);
+    for (std::size_t i = 0; i < interfaces; i++)
+        in_flight[i].store(0);
+}
+
+
+void FaultInjector::configure(std::size_t interface, const FaultConfig & next) {
+    config[interface] = next;
+    active[interface] = next.latency > 0.0 or next.drop_feedback > 0.0 or next.late_feedback > 0.0 or
+                        next.reject > 0.0 or next.max_in_flight > 0 or next.stall > 0.0;
+}
+
+
+void FaultInjector::configure_gaps(double probability, int64_t duration_ns) {
+    gap_probability = probability;
+    gap_duration_ns = duration_ns;
+}
+
+
+bool FaultInjector::enabled(std::size_t interface) const {
+    return active[interface] != 0;
+}
+
+
+// splitmix64 of the stream's draw count: any draw can be computed independently
+uint64_t FaultInjector::next(std::size_t stream) {
+    uint64_t z = seed + (stream + 1) * 0xD1B54A32D192ED03ULL +
+                 draws[stream].fetch_add(1, std::memory_order_relaxed) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+double FaultInjector::uniform(std::size_t stream) {
+    return static_cast<double>(next(stream) >> 11) * 0x1.0p-53;
+}
+
+
+// Box-Muller, one of the pair
+double FaultInjector::normal(std::size_t stream) {
+    const double u = 1.0 - uniform(stream);  // (0, 1]
+    const double v = uniform(stream);
+    return std::sqrt(-2.0 * std::log(u)) * std::cos(6.283185307179586 * v);
+}
+
+
+int64_t FaultInjector::latency_ns(std::size_t interface) {
+    const FaultConfig & c = config[interface];
+    if (c.latency <= 0.0)
+        return 0;
+    double seconds = c.latency;
+    switch (c.distribution) {
+        case LatencyDistribution::CONSTANT:
+            break;
+        case LatencyDistribution::UNIFORM:
+            seconds += c.jitter * (2.0 * uniform(interface) - 1.0);
+            break;
+        case LatencyDistribution::NORMAL:
+            seconds += c.jitter * normal(interface);
+            break;
+        case LatencyDistribution::EXPONENTIAL:
+            seconds = -c.latency * std::log(1.0 - uniform(interface));
+            break;
+        case LatencyDistribution::LOGNORMAL:
+            // Mean stays latency: jitter is the spread of its logarithm
+            seconds = c.latency * std::exp(c.jitter * normal(interface) - 0.5 * c.jitter * c.jitter);
+            break;
+    }
+    return static_cast<int64_t>(std::max(seconds, 0.0) * 1e9);
+}
+
+
+bool FaultInjector::drop_feedback(std::size_t interface) {
+    return config[interface].drop_feedback > 0.0 and uniform(interface) < config[interface].drop_feedback;
+}
+
+
+bool FaultInjector::late_feedback(std::size_t interface) {
+    return config[interface].late_feedback > 0.0 and uniform(interface) < config[interface].late_feedback;
+}
+
+
+bool FaultInjector::admit(std::size_t interface) {
+    const FaultConfig & c = config[interface];
+    if (c.reject > 0.0 and uniform(interface) < c.reject)
+        return false;
+    const int64_t before = in_flight[interface].fetch_add(1, std::memory_order_relaxed);
+    if (c.max_in_flight > 0 and before >= static_cast<int64_t>(c.max_in_flight)) {
+        in_flight[interface].fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+
+void FaultInjector::release(std::size_t interface) {
+    in_flight[interface].fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+int64_t FaultInjector::stall_ns(std::size_t interface) {
+    const FaultConfig & c = config[interface];
+    if (c.stall <= 0.0 or uniform(interface) >= c.stall)
+        return -1;
+    return static_cast<int64_t>(uniform(interface) * c.stall_after * 1e9);
+}
+
+
+bool FaultInjector::in_gap(int64_t stamp_ns) {
+    if (stamp_ns < gap_end_ns)
+        return true;
+    if (gap_probability <= 0.0 or uniform(interfaces) >= gap_probability)
+        return false;
+    gap_end_ns = stamp_ns + gap_duration_ns;
+    return true;
+}
+
+}  // namespace hal_fake_ptu
@@ -0,0 +1,182 @@
+#include "hal_fake_ptu/goal_scheduler.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+namespace hal_fake_ptu {
+
+SchedulingPolicy scheduling_policy_from_string(const std::string & name) {
+    if (name == "preempt")
+        return SchedulingPolicy::PREEMPT;
+    if (name == "queue")
+        return SchedulingPolicy::QUEUE;
+    if (name == "reject")
+        return SchedulingPolicy::REJECT;
+    throw std::invalid_argument("unknown scheduling policy '" + name + "'");
+}
+
+
+GoalScheduler::GoalScheduler(MotionEngine & engine, SchedulingPolicy policy, std::size_t max_queued)
+    : engine(engine), policy(policy), max_queued(max_queued) {}
+
+
+bool GoalScheduler::busy(const std::array<bool, AXIS_COUNT> & axes) const {
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        if (axes[axis] and (running[axis] > 0 or posted[axis] > 0))
+            return true;
+    }
+    return false;
+}
+
+
+bool GoalScheduler::admit(const std::array<bool, AXIS_COUNT> & axes) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    switch (policy) {
+        case SchedulingPolicy::PREEMPT:
+            return true;
+        case SchedulingPolicy::QUEUE:
+            return not busy(axes) or queue.size() < max_queued;
+        case SchedulingPolicy::REJECT:
+            return not busy(axes);
+    }
+    return false;
+}
+
+
+void GoalScheduler::submit(MoveCommand && command) {
+    bool rejected = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        bool blocked = busy(command.active);
+        if (policy == SchedulingPolicy::QUEUE and (blocked or not queue.empty())) {
+            if (queue.size() < max_queued)
+                queue.push_back(std::move(command));
+            else
+                rejected = true;
+            if (not rejected)
+                return;
+        } else if (policy == SchedulingPolicy::REJECT and blocked) {
+            rejected = true;
+        }
+    }
+
+    if (rejected) {
+        if (command.on_done)
+            command.on_done(MoveStatus::ABORTED);
+        return;
+    }
+    dispatch(std::move(command));
+}
+
+
+void GoalScheduler::dispatch(MoveCommand && command) {
+    const std::array<bool, AXIS_COUNT> axes = command.active;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            if (axes[axis])
+                running[axis]++;
+        }
+    }
+
+    auto on_done = std::move(command.on_done);
+    command.on_done = [this, axes, on_done](MoveStatus status) {
+        if (on_done)
+            on_done(status);
+        release(axes, running);
+    };
+    engine.post(std::move(command));
+}
+
+
+void GoalScheduler::post(MoveCommand && command) {
+    const std::array<bool, AXIS_COUNT> axes = command.active;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            if (axes[axis])
+                posted[axis]++;
+        }
+    }
+
+    auto on_done = std::move(command.on_done);
+    command.on_done = [this, axes, on_done](MoveStatus status) {
+        if (on_done)
+            on_done(status);
+        release(axes, posted);
+    };
+    engine.post(std::move(command));
+}
+
+
+// counts is running or posted, whichever the ended move was counted in
+void GoalScheduler::release(const std::array<bool, AXIS_COUNT> & axes, std::array<int, AXIS_COUNT> & counts) {
+    std::vector<MoveCommand> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            if (axes[axis])
+                counts[axis]--;
+        }
+
+        // Oldest first; a command waiting on an axis keeps later ones on that axis waiting.
+        // A goal preempted by a posted move frees nothing until that move ends.
+        std::array<bool, AXIS_COUNT> claimed;
+        for (int axis = 0; axis < AXIS_COUNT; axis++)
+            claimed[axis] = running[axis] > 0 or posted[axis] > 0;
+        for (auto it = queue.begin(); it != queue.end();) {
+            bool conflict = false;
+            for (int axis = 0; axis < AXIS_COUNT; axis++)
+                conflict = conflict or (it->active[axis] and claimed[axis]);
+            for (int axis = 0; axis < AXIS_COUNT; axis++)
+                claimed[axis] = claimed[axis] or it->active[axis];
+
+            if (conflict) {
+                ++it;
+            } else {
+                ready.push_back(std::move(*it));
+                it = queue.erase(it);
+            }
+        }
+    }
+
+    for (auto & command : ready)
+        dispatch(std::move(command));
+}
+
+
+void GoalScheduler::poll() {
+    std::vector<MoveCommand> canceled;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = queue.begin(); it != queue.end();) {
+            if (it->is_canceling and it->is_canceling()) {
+                canceled.push_back(std::move(*it));
+                it = queue.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    for (auto & command : canceled) {
+        if (command.on_done)
+            command.on_done(MoveStatus::CANCELED);
+    }
+}
+
+
+void GoalScheduler::clear() {
+    std::deque<MoveCommand> aborted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        aborted.swap(queue);
+    }
+
+    for (auto & command : aborted) {
+        if (command.on_done)
+            command.on_done(MoveStatus::ABORTED);
+    }
+}
+
+}  // namespace hal_fake_ptu
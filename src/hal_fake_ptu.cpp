@@ -1,4 +1,5 @@
 #include <iostream>
+#include <array>
 #include <chrono>
 #include <string>
 #include <functional>
@@ -6,9 +7,19 @@
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_action/rclcpp_action.hpp"
 #include "rclcpp_components/register_node_macro.hpp"
-
+#include "rclcpp_lifecycle/lifecycle_node.hpp"
+#include "rclcpp_lifecycle/lifecycle_publisher.hpp"
+
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <geometry_msgs/msg/transform_stamped.hpp>
+#include <lifecycle_msgs/msg/state.hpp>
+#include <rosgraph_msgs/msg/clock.hpp>
+#include <sensor_msgs/msg/joint_state.hpp>
 #include <std_msgs/msg/bool.hpp>
+#include <std_msgs/msg/float64.hpp>
 #include <std_srvs/srv/empty.hpp>
+#include <std_srvs/srv/trigger.hpp>
+#include <tf2_msgs/msg/tf_message.hpp>
 
 #include "ptu_interfaces/msg/ptu.hpp"
 #include "ptu_interfaces/srv/set_pan.hpp"
@@ -21,15 +32,44 @@
 #include "ptu_interfaces/action/set_tilt.hpp"
 #include "ptu_interfaces/action/set_pan_tilt.hpp"
 
+#include "hal_fake_ptu/action/follow_waypoints.hpp"
+#include "hal_fake_ptu/srv/predict_pose.hpp"
+
+#include "hal_fake_ptu/hal_fake_ptu.hpp"
+#include "hal_fake_ptu/axis_model.hpp"
+#include "hal_fake_ptu/fault_injector.hpp"
+#include "hal_fake_ptu/motion_engine.hpp"
+#include "hal_fake_ptu/goal_scheduler.hpp"
+#include "hal_fake_ptu/latency_histogram.hpp"
+#include "hal_fake_ptu/mapped_log.hpp"
+#include "hal_fake_ptu/pty_server.hpp"
+#include "hal_fake_ptu/seqlock.hpp"
+#include "hal_fake_ptu/serial_protocol.hpp"
+#include "hal_fake_ptu/shared_state_writer.hpp"
+#include "hal_fake_ptu/tick_thread.hpp"
+#include "hal_fake_ptu/timer_wheel.hpp"
+#include "hal_fake_ptu/trace_buffer.hpp"
+
 #include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
+#include <stdexcept>
+#include <limits>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 using namespace std::chrono_literals;
 namespace ph = std::placeholders;
 
-class HALFakePTU : public rclcpp::Node {
+class HALFakePTU : public rclcpp_lifecycle::LifecycleNode {
  public:
+    using CallbackReturn = rclcpp_lifecycle::node_interfaces::LifecycleNodeInterface::CallbackReturn;
+
     using SetPanAction = ptu_interfaces::action::SetPan;
     using GoalHandlePanAction = rclcpp_action::ServerGoalHandle<SetPanAction>;
 
@@ -39,303 +79,1786 @@ class HALFakePTU : public rclcpp::Node {
     using SetPanTiltAction = ptu_interfaces::action::SetPanTilt;
     using GoalHandlePanTiltAction = rclcpp_action::ServerGoalHandle<SetPanTiltAction>;
 
-    HALFakePTU() : Node("hal_fake_ptu") {}
-    
+    using FollowWaypointsAction = hal_fake_ptu::action::FollowWaypoints;
+    using GoalHandleWaypointsAction = rclcpp_action::ServerGoalHandle<FollowWaypointsAction>;
+
+    using SteadyClock = std::chrono::steady_clock;
+
+    explicit HALFakePTU(const rclcpp::NodeOptions & options = rclcpp::NodeOptions()) : LifecycleNode("hal_fake_ptu", options) {
+        // Read by main() to pick the executor, whatever the state; a component container has its own
+        declare_parameter<std::string>("executor.type", "multi_threaded");
+        declare_parameter<int64_t>("executor.threads", 0);
+
+        // Component containers only know the constructor, so unless a lifecycle
+        // manager is to drive it the node comes up active, as an unmanaged one would
+        if (declare_parameter("lifecycle.autostart", true)) {
+            if (configure().id() != lifecycle_msgs::msg::State::PRIMARY_STATE_INACTIVE)
+                throw std::runtime_error("invalid hal_fake_ptu parameters");
+            activate();
+        }
+    }
+
+    ~HALFakePTU(){
+        if (tick_thread)
+            tick_thread->stop();
+        for (auto & u : units) {
+            if (u.serial)
+                u.serial->stop();
+        }
+
+        // Queued and running goals must not outlive the node
+        for (std::size_t unit = 0; unit < units.size(); unit++) {
+            if (units[unit].scheduler)
+                units[unit].scheduler->clear();
+            if (engine)
+                engine->reset(unit);
+        }
+
+        if (trace and trace->enabled() and trace_on_shutdown)
+            trace->dump(trace_file);
+    }
+
+
+    // Interfaces and buffers are made by the first configure and kept until the
+    // node goes away: cleanup only resets the simulation, so cycling through
+    // the states takes milliseconds and peers never lose discovery.
+    CallbackReturn on_configure(const rclcpp_lifecycle::State &) override {
+        if (not initialized) {
+            initialized = true;
+            try {
+                configured = init();
+            } catch (const std::exception & e) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << e.what());
+            }
+        } else if (not configured) {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] Parameters are read once, restart the node to configure it again");
+        }
+        return configured ? CallbackReturn::SUCCESS : CallbackReturn::FAILURE;
+    }
+
+
+    CallbackReturn on_activate(const rclcpp_lifecycle::State &) override {
+        for (auto & publisher : managed_publishers)
+            publisher->on_activate();
+        active.store(true, std::memory_order_release);
+        RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Active");
+        return CallbackReturn::SUCCESS;
+    }
+
+
+    // Commands are refused from here on and every axis brakes where it is;
+    // the engine keeps ticking so the stop completes. The halts are traced
+    // and recorded like any other move, so a replay stops where this run did.
+    CallbackReturn on_deactivate(const rclcpp_lifecycle::State &) override {
+        active.store(false, std::memory_order_release);
+        for (std::size_t unit = 0; unit < units.size(); unit++) {
+            units[unit].scheduler->clear();
+            hal_fake_ptu::MoveCommand halt;
+            halt.unit = unit;
+            halt.active = {{true, true}};
+            halt.target = engine->snapshot(unit).position;
+            halt.is_canceling = [](){ return true; };
+            dispatch(std::move(halt), false);
+        }
+        for (auto & publisher : managed_publishers)
+            publisher->on_deactivate();
+        RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Inactive");
+        return CallbackReturn::SUCCESS;
+    }
+
+
+    // What /ptu/reset does for every unit, plus the speeds, axis models and
+    // statistics a scenario may have changed. Parameters keep their values;
+    // the trace, the log, /clock and a replay go on from where they are.
+    CallbackReturn on_cleanup(const rclcpp_lifecycle::State &) override {
+        for (std::size_t unit = 0; unit < units.size(); unit++)
+            apply_reset(unit);
+        engine->configure(config.load().axes);
+        {
+            std::lock_guard<std::mutex> lock(goals_mutex);
+            for (auto & u : units)
+                u.goals.clear();
+        }
+        // The models belong to the tick, which resets them at its next step
+        if (models)
+            models_reset.store(true, std::memory_order_release);
+        // A collect() nobody reads starts every histogram afresh
+        for (auto & histograms : latency) {
+            for (auto & histogram : histograms)
+                histogram.collect();
+        }
+        tick_latency.collect();
+        tick_overruns.store(0, std::memory_order_relaxed);
+        RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Reset");
+        return CallbackReturn::SUCCESS;
+    }
+
+
+    CallbackReturn on_shutdown(const rclcpp_lifecycle::State &) override {
+        active.store(false, std::memory_order_release);
+        if (tick_thread)
+            tick_thread->stop();
+        for (auto & u : units) {
+            if (u.serial)
+                u.serial->stop();
+        }
+        return CallbackReturn::SUCCESS;
+    }
+
+
+ private:
     bool init() {
 
-        current_pan = 0.0;
-        current_tilt = 0.0;
+        // Engine tick and publishing, commands, and action goals and cancels each
+        // run in their own group: on a multi-threaded executor none of them waits
+        // behind another. Each group is mutually exclusive within itself.
+        publishing_group = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+        commands_group = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+        actions_group = create_callback_group(rclcpp::CallbackGroupType::MutuallyExclusive);
+
+        const std::string executor_type = get_parameter("executor.type").as_string();
+        const int64_t executor_threads = get_parameter("executor.threads").as_int();
+        if (executor_type != "multi_threaded" and executor_type != "single_threaded" and
+            executor_type != "static_single_threaded" and executor_type != "events") {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] executor.type must be multi_threaded, single_threaded, static_single_threaded or events");
+            return false;
+        }
+        if (executor_threads < 0) {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] executor.threads must not be negative");
+            return false;
+        }
 
-        tilt_min = declare_parameter("limits.min_tilt", -0.5);
-        tilt_max = declare_parameter("limits.max_tilt", 0.5);
-        tilt_speed = declare_parameter("limits.tilt_speed", 0.1);
+        // Settings that can also be changed while running, see on_parameters
+        Config initial;
+        initial.tilt_min = declare_parameter("limits.min_tilt", -0.5);
+        initial.tilt_max = declare_parameter("limits.max_tilt", 0.5);
+        initial.axes[hal_fake_ptu::TILT].speed = declare_parameter("limits.tilt_speed", 0.1);
+        initial.axes[hal_fake_ptu::TILT].acceleration = declare_parameter("limits.tilt_acceleration", 0.2);
         
-        pan_min = declare_parameter("limits.min_pan", -1.0);
-        pan_max = declare_parameter("limits.max_pan", 1.0);
-        pan_speed = declare_parameter("limits.pan_speed", 0.1);
+        initial.pan_min = declare_parameter("limits.min_pan", -1.0);
+        initial.pan_max = declare_parameter("limits.max_pan", 1.0);
+        initial.axes[hal_fake_ptu::PAN].speed = declare_parameter("limits.pan_speed", 0.1);
+        initial.axes[hal_fake_ptu::PAN].acceleration = declare_parameter("limits.pan_acceleration", 0.2);
+
+        initial.internal_rate = declare_parameter("internal_rate", 100.0);
+
+        initial.axes[hal_fake_ptu::PAN].threshold = declare_parameter("min_thresold_command_input_pan", 0.001);
+        initial.axes[hal_fake_ptu::TILT].threshold = declare_parameter("min_thresold_command_input_tilt", 0.001);
+
+        // State rate when not adaptive. Adaptive: state published from the engine tick at
+        // moving_hz while any axis moves, idle_hz when parked, and at once on every start and stop.
+        initial.hz = declare_parameter("hz", 10.0);
+        initial.moving_hz = declare_parameter("publishing.moving_hz", initial.internal_rate);
+        initial.idle_hz = declare_parameter("publishing.idle_hz", 1.0);
+
+        const std::string invalid = check(initial);
+        if (not invalid.empty()) {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << invalid);
+            return false;
+        }
+        config.store(initial);
+        engine_period_ns = static_cast<int64_t>(1e9 / initial.internal_rate);
+        publish_period_ns = static_cast<int64_t>(1e9 / initial.hz);
+        moving_period_ns = static_cast<int64_t>(1e9 / initial.moving_hz);
+        idle_period_ns = static_cast<int64_t>(1e9 / initial.idle_hz);
+        const std::array<hal_fake_ptu::AxisConfig, hal_fake_ptu::AXIS_COUNT> & axes = initial.axes;
+
+        // Fleet mode: one unit per namespace, all stepped by the same engine tick.
+        // Without it there is a single unit with the interface names as given.
+        std::vector<std::string> namespaces = declare_parameter<std::vector<std::string>>("fleet.namespaces", std::vector<std::string>{});
+        if (namespaces.empty())
+            namespaces.push_back("");
+        for (auto & ns : namespaces) {
+            while (not ns.empty() and ns.back() == '/')
+                ns.pop_back();
+            if (not ns.empty() and ns.front() != '/')
+                ns.insert(ns.begin(), '/');
+        }
 
-        min_step = declare_parameter("ptu_resolution", 0.1);
-        internal_rate = declare_parameter("internal_rate", 100.0);
+        engine = std::make_unique<hal_fake_ptu::MotionEngine>(namespaces.size(), axes);
+
+        // Actuator and encoder imperfections between the planned motion and the reported state
+        std::array<hal_fake_ptu::AxisModelConfig, hal_fake_ptu::AXIS_COUNT> model_configs;
+        std::array<unsigned, hal_fake_ptu::AXIS_COUNT> model_effects;
+        static const char * const model_axis[hal_fake_ptu::AXIS_COUNT] = {"pan", "tilt"};
+        const int64_t model_seed = declare_parameter<int64_t>("model.seed", 0);
+        for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++) {
+            const std::string prefix = std::string("model.") + model_axis[axis] + ".";
+            try {
+                model_effects[axis] = hal_fake_ptu::axis_effects_from_strings(
+                    declare_parameter<std::vector<std::string>>(prefix + "effects", std::vector<std::string>{}));
+            } catch (const std::invalid_argument & e) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << prefix << "effects: " << e.what());
+                return false;
+            }
+            hal_fake_ptu::AxisModelConfig & config = model_configs[axis];
+            config.lag = declare_parameter(prefix + "lag", 0.05);
+            config.max_velocity = declare_parameter(prefix + "max_velocity", 0.0);
+            config.max_acceleration = declare_parameter(prefix + "max_acceleration", 0.0);
+            config.backlash = declare_parameter(prefix + "backlash", 0.0);
+            config.noise = declare_parameter(prefix + "noise", 0.0);
+            config.resolution = declare_parameter(prefix + "resolution", 0.0);
+            if (config.lag < 0.0 or config.max_velocity < 0.0 or config.max_acceleration < 0.0 or
+                config.backlash < 0.0 or config.noise < 0.0 or config.resolution < 0.0) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << prefix << "*: lag, limits, backlash, noise and resolution must not be negative");
+                return false;
+            }
+            if ((model_effects[axis] & hal_fake_ptu::QUANTIZATION) != 0 and config.resolution <= 0.0) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << prefix << "resolution must be positive with quantization");
+                return false;
+            }
+        }
+        if (model_effects[hal_fake_ptu::PAN] != 0 or model_effects[hal_fake_ptu::TILT] != 0) {
+            std::vector<hal_fake_ptu::AxisModelConfig> configs;
+            std::vector<unsigned> effects;
+            for (std::size_t unit = 0; unit < namespaces.size(); unit++) {
+                for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++) {
+                    configs.push_back(model_configs[axis]);
+                    configs.back().seed = static_cast<uint64_t>(model_seed) + configs.size();
+                    effects.push_back(model_effects[axis]);
+                }
+            }
+            models = std::make_unique<hal_fake_ptu::AxisModelBank>(configs, effects);
+            model_command.resize(configs.size());
+            model_ideal.resize(namespaces.size());
+            measured.reset(new hal_fake_ptu::SeqLock<hal_fake_ptu::PTUState>[namespaces.size()]);
+        }
 
-        min_threshold_to_move_pan = declare_parameter("min_thresold_command_input_pan", 0.001);
-        min_threshold_to_move_tilt = declare_parameter("min_thresold_command_input_tilt", 0.001);
+        // What an action goal does to the goal already running on its axes: preempt, queue or reject
+        std::string goal_policy = declare_parameter<std::string>("goals.policy", "preempt");
+        int64_t goal_max_queued = declare_parameter<int64_t>("goals.max_queued", 4);
+        hal_fake_ptu::SchedulingPolicy policy;
+        try {
+            policy = hal_fake_ptu::scheduling_policy_from_string(goal_policy);
+        } catch (const std::invalid_argument & e) {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << e.what());
+            return false;
+        }
+        const std::size_t max_queued = static_cast<std::size_t>(std::max<int64_t>(goal_max_queued, 0));
+
+        // Binary trace of axis samples and commands instead of per-step logging
+        int64_t trace_capacity = declare_parameter<int64_t>("trace.capacity", 65536);
+        trace_file = declare_parameter<std::string>("trace.file", "/tmp/hal_fake_ptu_trace.bin");
+        trace_on_shutdown = declare_parameter("trace.dump_on_shutdown", true);
+        trace = std::make_unique<hal_fake_ptu::TraceBuffer>(static_cast<std::size_t>(std::max<int64_t>(trace_capacity, 0)));
+
+        // Durable log of every input and state sample, and replay of such a log
+        std::string record_file = declare_parameter<std::string>("record.file", "");
+        int64_t record_capacity = declare_parameter<int64_t>("record.capacity", 2097152);
+        std::string replay_file = declare_parameter<std::string>("replay.file", "");
+        double replay_speedup = declare_parameter("replay.speedup", 1.0);
+        try {
+            if (not replay_file.empty())
+                replay = hal_fake_ptu::MappedLog::open(replay_file);
+            if (not record_file.empty())
+                log = hal_fake_ptu::MappedLog::create(record_file, static_cast<std::size_t>(std::max<int64_t>(record_capacity, 0)));
+        } catch (const std::exception & e) {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << e.what());
+            return false;
+        }
 
         std::string ptu_state_publisher = declare_parameter<std::string>("publishers.state", "/ptu/state");
+        std::string diagnostics_publisher = declare_parameter<std::string>("publishers.diagnostics", "/diagnostics");
+
+        // State QoS: reliability, history depth and, when positive, deadline and lifespan in seconds
+        rclcpp::QoS state_qos(static_cast<std::size_t>(std::max<int64_t>(declare_parameter<int64_t>("qos.state.depth", 1), 1)));
+        std::string state_reliability = declare_parameter<std::string>("qos.state.reliability", "reliable");
+        if (state_reliability == "best_effort") {
+            state_qos.best_effort();
+        } else if (state_reliability == "reliable") {
+            state_qos.reliable();
+        } else {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] unknown qos.state.reliability '" << state_reliability << "', expected reliable or best_effort");
+            return false;
+        }
+        double state_deadline = declare_parameter("qos.state.deadline", 0.0);
+        double state_lifespan = declare_parameter("qos.state.lifespan", 0.0);
+        if (state_deadline > 0.0)
+            state_qos.deadline(rclcpp::Duration::from_seconds(state_deadline));
+        if (state_lifespan > 0.0)
+            state_qos.lifespan(rclcpp::Duration::from_seconds(state_lifespan));
+        intra_process = get_node_options().use_intra_process_comms();
+
+        // Joint states and the base -> pan -> tilt transforms, every engine tick. Pan turns
+        // about z, tilt about y; offsets are the joint origins in the parent frame.
+        bool joint_states_enabled = declare_parameter("joint_states.enabled", true);
+        std::string joint_states_publisher = declare_parameter<std::string>("publishers.joint_states", "/joint_states");
+        std::string pan_joint = declare_parameter<std::string>("joint_states.pan_joint", "ptu_pan_joint");
+        std::string tilt_joint = declare_parameter<std::string>("joint_states.tilt_joint", "ptu_tilt_joint");
+        bool tf_enabled = declare_parameter("tf.enabled", true);
+        std::string base_frame = declare_parameter<std::string>("tf.base_frame", "ptu_base_link");
+        std::string pan_frame = declare_parameter<std::string>("tf.pan_frame", "ptu_pan_link");
+        std::string tilt_frame = declare_parameter<std::string>("tf.tilt_frame", "ptu_tilt_link");
+        std::vector<double> pan_offset = declare_parameter<std::vector<double>>("tf.pan_offset", {0.0, 0.0, 0.0});
+        std::vector<double> tilt_offset = declare_parameter<std::vector<double>>("tf.tilt_offset", {0.0, 0.0, 0.0});
+        if (pan_offset.size() != 3 or tilt_offset.size() != 3) {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] tf.pan_offset and tf.tilt_offset must be [x, y, z]");
+            return false;
+        }
+        if (tf_enabled)
+            tf_pub = managed_publisher<tf2_msgs::msg::TFMessage>("/tf", rclcpp::QoS(100));
         std::string set_pan_srv_name = declare_parameter<std::string>("services.set_pan", "/ptu/set_pan");
         std::string set_tilt_srv_name = declare_parameter<std::string>("services.set_tilt", "/ptu/set_tilt");
         std::string set_pantilt_srv_name = declare_parameter<std::string>("services.set_pantilt", "/ptu/set_pan_tilt");
         std::string set_pantilt_speed_srv_name = declare_parameter<std::string>("services.set_pantilt_speed", "/ptu/set_pan_tilt_speed");
         std::string set_reset_srv_name = declare_parameter<std::string>("services.reset", "/ptu/reset");
         std::string set_get_limits_srv_name = declare_parameter<std::string>("services.get_limits", "/ptu/get_limits");
+        std::string dump_trace_srv_name = declare_parameter<std::string>("services.dump_trace", "/ptu/dump_trace");
+        std::string predict_pose_srv_name = declare_parameter<std::string>("services.predict_pose", "/ptu/predict_pose");
+
+        // Streaming setpoints for closed-loop clients, latest value wins
+        std::string pan_setpoint_name = declare_parameter<std::string>("subscribers.pan_setpoint", "/ptu/setpoint/pan");
+        std::string tilt_setpoint_name = declare_parameter<std::string>("subscribers.tilt_setpoint", "/ptu/setpoint/tilt");
+        std::string pan_velocity_name = declare_parameter<std::string>("subscribers.pan_velocity", "/ptu/setpoint/pan_velocity");
+        std::string tilt_velocity_name = declare_parameter<std::string>("subscribers.tilt_velocity", "/ptu/setpoint/tilt_velocity");
 
         std::string set_pan_action_name = declare_parameter<std::string>("actions.set_pan", "/ptu/set_pan");
         std::string set_tilt_action_name = declare_parameter<std::string>("actions.set_tilt", "/ptu/set_tilt");
         std::string set_pantilt_action_name = declare_parameter<std::string>("actions.set_pantilt", "/ptu/set_pan_tilt");
+        std::string follow_waypoints_action_name = declare_parameter<std::string>("actions.follow_waypoints", "/ptu/follow_waypoints");
+
+        // Command latency and tick overruns of the last period, 0 disables them
+        double diagnostics_period = declare_parameter("diagnostics.period", 1.0);
+        if (diagnostics_period > 0.0) {
+            diagnostics_pub = managed_publisher<diagnostic_msgs::msg::DiagnosticArray>(diagnostics_publisher, 10);
+            diagnostics_timer_ = create_wall_timer(std::chrono::duration<double>(diagnostics_period),
+                                                   std::bind(&HALFakePTU::diagnosticsCallback, this), publishing_group);
+        }
 
-        ptu_state_pub = create_publisher<ptu_interfaces::msg::PTU>(ptu_state_publisher, 1);
-
-        set_pan_srv = create_service<ptu_interfaces::srv::SetPan>(set_pan_srv_name, std::bind(&HALFakePTU::set_pan_callback, this, std::placeholders::_1, std::placeholders::_2));    
+        dump_trace_srv = create_service<std_srvs::srv::Trigger>(dump_trace_srv_name, std::bind(&HALFakePTU::dump_trace_callback, this, std::placeholders::_1, std::placeholders::_2),
+                rmw_qos_profile_services_default, commands_group);
+
+        // Emulated transport faults in front of the command interfaces, for stress
+        // testing clients. Off during replay, which reproduces the recorded run.
+        bool faults_enabled = declare_parameter("faults.enabled", false);
+        auto fault_injector = std::make_unique<hal_fake_ptu::FaultInjector>(FAULT_INTERFACES,
+            static_cast<uint64_t>(declare_parameter<int64_t>("faults.seed", 0)));
+        const char * fault_keys[FAULT_INTERFACES] = {
+            "set_pan_service", "set_tilt_service", "set_pantilt_service",
+            "set_pan_action", "set_tilt_action", "set_pantilt_action", "follow_waypoints_action"};
+        for (std::size_t i = 0; i < FAULT_INTERFACES; i++) {
+            const std::string key = std::string("faults.") + fault_keys[i] + ".";
+            hal_fake_ptu::FaultConfig fault;
+            const std::string distribution = declare_parameter<std::string>(key + "latency.distribution", "constant");
+            fault.latency = declare_parameter(key + "latency.mean", 0.0);
+            fault.jitter = declare_parameter(key + "latency.jitter", 0.0);
+            fault.drop_feedback = declare_parameter(key + "feedback.drop", 0.0);
+            fault.late_feedback = declare_parameter(key + "feedback.late", 0.0);
+            fault.reject = declare_parameter(key + "reject", 0.0);
+            const int64_t max_in_flight = declare_parameter<int64_t>(key + "max_in_flight", 0);
+            fault.stall = declare_parameter(key + "stall", 0.0);
+            fault.stall_after = declare_parameter(key + "stall_after", 1.0);
+            try {
+                fault.distribution = hal_fake_ptu::latency_distribution_from_string(distribution);
+            } catch (const std::invalid_argument & e) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << key << "latency.distribution: " << e.what());
+                return false;
+            }
+            auto probability = [](double p){ return p >= 0.0 and p <= 1.0; };
+            if (not probability(fault.drop_feedback) or not probability(fault.late_feedback) or not probability(fault.reject) or
+                not probability(fault.stall) or fault.latency < 0.0 or fault.jitter < 0.0 or fault.stall_after <= 0.0 or max_in_flight < 0) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] " << key << "*: probabilities must be within [0, 1], durations and counts positive");
+                return false;
+            }
+            fault.max_in_flight = static_cast<std::size_t>(max_in_flight);
+            fault_injector->configure(i, fault);
+        }
+        double state_gap = declare_parameter("faults.state.gap", 0.0);
+        double state_gap_duration = declare_parameter("faults.state.gap_duration", 0.5);
+        if (state_gap < 0.0 or state_gap > 1.0 or state_gap_duration < 0.0) {
+            RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] faults.state.gap must be within [0, 1], gap_duration not negative");
+            return false;
+        }
+        fault_injector->configure_gaps(state_gap, static_cast<int64_t>(state_gap_duration * 1e9));
+        if (faults_enabled and replay) {
+            RCLCPP_WARN_STREAM(get_logger(), "[FAKE PTU] faults.enabled is ignored during replay");
+        } else if (faults_enabled) {
+            faults = std::move(fault_injector);
+            delayed = std::make_unique<hal_fake_ptu::TimerWheel>(engine_period_ns.load());
+            RCLCPP_WARN_STREAM(get_logger(), "[FAKE PTU] Emulating transport faults");
+        }
 
-        set_tilt_srv = create_service<ptu_interfaces::srv::SetTilt>(set_tilt_srv_name, std::bind(&HALFakePTU::set_tilt_callback, this, std::placeholders::_1, std::placeholders::_2));    
+        units.resize(namespaces.size());
+        for (std::size_t unit = 0; unit < units.size(); unit++) {
+            Unit & u = units[unit];
+            const std::string & ns = namespaces[unit];
+            u.scheduler = std::make_unique<hal_fake_ptu::GoalScheduler>(*engine, policy, max_queued);
+
+            u.ptu_state_pub = managed_publisher<ptu_interfaces::msg::PTU>(ns + ptu_state_publisher, state_qos);
+
+            // Allocated once here, only values and stamps change afterwards.
+            // Fleet units prefix joints and frames with their namespace, e.g. ptu0/ptu_pan_joint.
+            const std::string prefix = ns.empty() ? "" : ns.substr(1) + "/";
+            if (joint_states_enabled) {
+                u.joint_state_pub = managed_publisher<sensor_msgs::msg::JointState>(ns + joint_states_publisher, 10);
+                u.joint_state_msg.name = {prefix + pan_joint, prefix + tilt_joint};
+                u.joint_state_msg.position.assign(hal_fake_ptu::AXIS_COUNT, 0.0);
+                u.joint_state_msg.velocity.assign(hal_fake_ptu::AXIS_COUNT, 0.0);
+            }
+            if (tf_enabled) {
+                geometry_msgs::msg::TransformStamped pan;
+                pan.header.frame_id = prefix + base_frame;
+                pan.child_frame_id = prefix + pan_frame;
+                pan.transform.translation.x = pan_offset[0];
+                pan.transform.translation.y = pan_offset[1];
+                pan.transform.translation.z = pan_offset[2];
+                tf_msg.transforms.push_back(pan);
+
+                geometry_msgs::msg::TransformStamped tilt;
+                tilt.header.frame_id = prefix + pan_frame;
+                tilt.child_frame_id = prefix + tilt_frame;
+                tilt.transform.translation.x = tilt_offset[0];
+                tilt.transform.translation.y = tilt_offset[1];
+                tilt.transform.translation.z = tilt_offset[2];
+                tf_msg.transforms.push_back(tilt);
+            }
 
-        set_pantilt_srv = create_service<ptu_interfaces::srv::SetPanTilt>(set_pantilt_srv_name, std::bind(&HALFakePTU::set_pantilt_callback, this, std::placeholders::_1, std::placeholders::_2));    
+            // Depth 1 best effort: a late setpoint is worthless once a newer one exists
+            const rclcpp::QoS setpoint_qos = rclcpp::QoS(1).best_effort();
+            rclcpp::SubscriptionOptions commands_options;
+            commands_options.callback_group = commands_group;
+            u.pan_setpoint_sub = create_subscription<std_msgs::msg::Float64>(ns + pan_setpoint_name, setpoint_qos,
+                [this, unit](const std_msgs::msg::Float64::ConstSharedPtr msg){ position_setpoint_callback(unit, hal_fake_ptu::PAN, msg->data); }, commands_options);
+            u.tilt_setpoint_sub = create_subscription<std_msgs::msg::Float64>(ns + tilt_setpoint_name, setpoint_qos,
+                [this, unit](const std_msgs::msg::Float64::ConstSharedPtr msg){ position_setpoint_callback(unit, hal_fake_ptu::TILT, msg->data); }, commands_options);
+            u.pan_velocity_sub = create_subscription<std_msgs::msg::Float64>(ns + pan_velocity_name, setpoint_qos,
+                [this, unit](const std_msgs::msg::Float64::ConstSharedPtr msg){ velocity_setpoint_callback(unit, hal_fake_ptu::PAN, msg->data); }, commands_options);
+            u.tilt_velocity_sub = create_subscription<std_msgs::msg::Float64>(ns + tilt_velocity_name, setpoint_qos,
+                [this, unit](const std_msgs::msg::Float64::ConstSharedPtr msg){ velocity_setpoint_callback(unit, hal_fake_ptu::TILT, msg->data); }, commands_options);
+
+            u.set_pan_srv = create_service<ptu_interfaces::srv::SetPan>(ns + set_pan_srv_name,
+                [this, unit](const std::shared_ptr<rclcpp::Service<ptu_interfaces::srv::SetPan>> service,
+                             const std::shared_ptr<rmw_request_id_t> request_header,
+                             const std::shared_ptr<ptu_interfaces::srv::SetPan::Request> request){
+                    set_pan_callback(unit, service, request_header, request);
+                }, rmw_qos_profile_services_default, commands_group);
+
+            u.set_tilt_srv = create_service<ptu_interfaces::srv::SetTilt>(ns + set_tilt_srv_name,
+                [this, unit](const std::shared_ptr<rclcpp::Service<ptu_interfaces::srv::SetTilt>> service,
+                             const std::shared_ptr<rmw_request_id_t> request_header,
+                             const std::shared_ptr<ptu_interfaces::srv::SetTilt::Request> request){
+                    set_tilt_callback(unit, service, request_header, request);
+                }, rmw_qos_profile_services_default, commands_group);
+
+            u.set_pantilt_srv = create_service<ptu_interfaces::srv::SetPanTilt>(ns + set_pantilt_srv_name,
+                [this, unit](const std::shared_ptr<rclcpp::Service<ptu_interfaces::srv::SetPanTilt>> service,
+                             const std::shared_ptr<rmw_request_id_t> request_header,
+                             const std::shared_ptr<ptu_interfaces::srv::SetPanTilt::Request> request){
+                    set_pantilt_callback(unit, service, request_header, request);
+                }, rmw_qos_profile_services_default, commands_group);
+
+            u.set_pantilt_speed_srv = create_service<ptu_interfaces::srv::SetPanTiltSpeed>(ns + set_pantilt_speed_srv_name,
+                [this, unit](const std::shared_ptr<ptu_interfaces::srv::SetPanTiltSpeed::Request> request,
+                             std::shared_ptr<ptu_interfaces::srv::SetPanTiltSpeed::Response> response){
+                    set_pantilt_speed_callback(unit, request, response);
+                }, rmw_qos_profile_services_default, commands_group);
+
+            u.reset_srv = create_service<std_srvs::srv::Empty>(ns + set_reset_srv_name,
+                [this, unit](const std::shared_ptr<std_srvs::srv::Empty::Request> request,
+                             std::shared_ptr<std_srvs::srv::Empty::Response> response){
+                    resetCallback(unit, request, response);
+                }, rmw_qos_profile_services_default, commands_group);
+
+            u.get_limits_srv = create_service<ptu_interfaces::srv::GetLimits>(ns + set_get_limits_srv_name, std::bind(&HALFakePTU::get_limits_callback, this, std::placeholders::_1, std::placeholders::_2),
+                rmw_qos_profile_services_default, commands_group);
+
+            u.predict_pose_srv = create_service<hal_fake_ptu::srv::PredictPose>(ns + predict_pose_srv_name,
+                [this, unit](const std::shared_ptr<hal_fake_ptu::srv::PredictPose::Request> request,
+                             std::shared_ptr<hal_fake_ptu::srv::PredictPose::Response> response){
+                    predict_pose_callback(unit, request, response);
+                }, rmw_qos_profile_services_default, commands_group);
+
+            u.action_server_set_pan = rclcpp_action::create_server<SetPanAction>(
+                this,
+                ns + set_pan_action_name,
+                std::bind(&HALFakePTU::handle_goal_pan, this, unit, std::placeholders::_1, std::placeholders::_2),
+                std::bind(&HALFakePTU::handle_cancel_pan, this, std::placeholders::_1),
+                std::bind(&HALFakePTU::handle_accepted_pan, this, unit, std::placeholders::_1),
+                rcl_action_server_get_default_options(), actions_group
+            );
+
+
+            u.action_server_set_tilt = rclcpp_action::create_server<SetTiltAction>(
+                this,
+                ns + set_tilt_action_name,
+                std::bind(&HALFakePTU::handle_goal_tilt, this, unit, std::placeholders::_1, std::placeholders::_2),
+                std::bind(&HALFakePTU::handle_cancel_tilt, this, std::placeholders::_1),
+                std::bind(&HALFakePTU::handle_accepted_tilt, this, unit, std::placeholders::_1),
+                rcl_action_server_get_default_options(), actions_group
+            );
+
+
+            u.action_server_set_pantilt = rclcpp_action::create_server<SetPanTiltAction>(
+                this,
+                ns + set_pantilt_action_name,
+                std::bind(&HALFakePTU::handle_goal_pantilt, this, unit, std::placeholders::_1, std::placeholders::_2),
+                std::bind(&HALFakePTU::handle_cancel_pantilt, this, std::placeholders::_1),
+                std::bind(&HALFakePTU::handle_accepted_pantilt, this, unit, std::placeholders::_1),
+                rcl_action_server_get_default_options(), actions_group
+            );
+
+
+            u.action_server_follow_waypoints = rclcpp_action::create_server<FollowWaypointsAction>(
+                this,
+                ns + follow_waypoints_action_name,
+                std::bind(&HALFakePTU::handle_goal_waypoints, this, unit, std::placeholders::_1, std::placeholders::_2),
+                std::bind(&HALFakePTU::handle_cancel_waypoints, this, std::placeholders::_1),
+                std::bind(&HALFakePTU::handle_accepted_waypoints, this, unit, std::placeholders::_1),
+                rcl_action_server_get_default_options(), actions_group
+            );
+        }
 
-        set_pantilt_speed_srv = create_service<ptu_interfaces::srv::SetPanTiltSpeed>(set_pantilt_speed_srv_name, std::bind(&HALFakePTU::set_pantilt_speed_callback, this, std::placeholders::_1, std::placeholders::_2));    
+        adaptive_publishing = declare_parameter("publishing.adaptive", true);
+
+        // Headless runs: step simulated time ourselves and publish it on /clock,
+        // speedup times faster than real time (0 = as fast as possible)
+        publish_clock = declare_parameter("simulation.publish_clock", false);
+        speedup = declare_parameter("simulation.speedup", 1.0);
+
+        // Engine tick on a dedicated thread sleeping to absolute deadlines instead of an executor timer
+        bool realtime = declare_parameter("realtime.enabled", false);
+        hal_fake_ptu::TickThreadConfig tick_config;
+        tick_config.cpu = static_cast<int>(declare_parameter<int64_t>("realtime.cpu", -1));
+        tick_config.policy = declare_parameter<std::string>("realtime.policy", "other");
+        tick_config.priority = static_cast<int>(declare_parameter<int64_t>("realtime.priority", 80));
+        tick_config.lock_memory = declare_parameter("realtime.lock_memory", false);
+
+        if (replay) {
+            // The log sets the pace: inputs in order, each TICK at its recorded stamp
+            set_parameter(rclcpp::Parameter("use_sim_time", true));
+            clock_pub = make_clock_publisher();
+
+            auto step_period = std::chrono::nanoseconds(replay_speedup > 0.0 ? static_cast<int64_t>(engine_period_ns / replay_speedup) : 0);
+            engine_timer_ = this->create_wall_timer(step_period, std::bind(&HALFakePTU::replayCallback, this), publishing_group);
+            replay_path.resize(units.size());
+            RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Replaying " << replay->size() << " records from " << replay_file);
+        } else if (publish_clock) {
+            set_parameter(rclcpp::Parameter("use_sim_time", true));
+            clock_pub = make_clock_publisher();
+
+            schedule_engine();
+            RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Publishing /clock, speedup " << speedup);
+            if (realtime)
+                RCLCPP_WARN_STREAM(get_logger(), "[FAKE PTU] realtime.enabled is ignored with simulation.publish_clock");
+        } else {
+            if (not adaptive_publishing)
+                schedule_publishing();
+
+            // Single motion tick shared by every service and action goal
+            if (realtime) {
+                tick_budget_ns = engine_period_ns.load();
+                tick_config.period_ns = engine_period_ns;
+                try {
+                    tick_thread = std::make_unique<hal_fake_ptu::TickThread>(tick_config, [this](){ engineCallback(now().nanoseconds()); });
+                } catch (const std::invalid_argument & e) {
+                    RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] realtime: " << e.what());
+                    return false;
+                }
+                for (const std::string & failure : tick_thread->start())
+                    RCLCPP_WARN_STREAM(get_logger(), "[FAKE PTU] realtime: cannot set " << failure);
+                RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Engine ticking on a dedicated " << tick_config.policy << " thread");
+            } else {
+                schedule_engine();
+            }
+        }
 
-        reset_srv = create_service<std_srvs::srv::Empty>(set_reset_srv_name, std::bind(&HALFakePTU::resetCallback, this, std::placeholders::_1, std::placeholders::_2));
+        // Serial port front end: each unit also answers a PTU ASCII protocol on a pty,
+        // for testing real drivers. With a fleet the link gets the unit index appended.
+        bool serial_enabled = declare_parameter("serial.enabled", false);
+        std::string serial_link = declare_parameter<std::string>("serial.link", "/tmp/hal_fake_ptu_serial");
+        double serial_resolution = declare_parameter("serial.resolution", 0.0009);
+        if (serial_enabled and replay) {
+            RCLCPP_WARN_STREAM(get_logger(), "[FAKE PTU] serial.enabled is ignored during replay");
+        } else if (serial_enabled) {
+            if (serial_resolution <= 0.0) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] serial.resolution must be positive");
+                return false;
+            }
+            for (std::size_t unit = 0; unit < units.size(); unit++) {
+                Unit & u = units[unit];
+                const std::string link = serial_link.empty() or units.size() == 1 ? serial_link : serial_link + std::to_string(unit);
+                u.serial_protocol = std::make_unique<hal_fake_ptu::SerialProtocol>(serial_handlers(unit), serial_resolution);
+                try {
+                    u.serial = std::make_unique<hal_fake_ptu::PtyServer>(*u.serial_protocol, link);
+                } catch (const std::exception & e) {
+                    RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] serial: " << e.what());
+                    return false;
+                }
+                u.serial->start();
+                RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Serial port on " << u.serial->device() << (link.empty() ? "" : ", linked from " + link));
+            }
+        }
 
-        get_limits_srv = create_service<ptu_interfaces::srv::GetLimits>(set_get_limits_srv_name, std::bind(&HALFakePTU::get_limits_callback, this, std::placeholders::_1, std::placeholders::_2));
+        // Shared memory mirror of the axis state, for same-host consumers that
+        // sample it without ROS. See include/hal_fake_ptu/shared_state.hpp.
+        std::string shared_memory_name = declare_parameter<std::string>("shared_memory.name", "");
+        if (not shared_memory_name.empty()) {
+            try {
+                shared_state = hal_fake_ptu::SharedStateWriter::create(shared_memory_name, units.size());
+            } catch (const std::exception & e) {
+                RCLCPP_ERROR_STREAM(get_logger(), "[FAKE PTU] shared_memory: " << e.what());
+                return false;
+            }
+            RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Axis state mirrored in shared memory " << shared_memory_name);
+        }
 
-        this->action_server_set_pan = rclcpp_action::create_server<SetPanAction>(
-            this,
-            set_pan_action_name,
-            std::bind(&HALFakePTU::handle_goal_pan, this, std::placeholders::_1, std::placeholders::_2),
-            std::bind(&HALFakePTU::handle_cancel_pan, this, std::placeholders::_1),
-            std::bind(&HALFakePTU::handle_accepted_pan, this, std::placeholders::_1)
-        );
+        // Declared from here on, every change goes through on_parameters
+        parameters_handle = add_on_set_parameters_callback(std::bind(&HALFakePTU::on_parameters, this, std::placeholders::_1));
+      
+        RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Node Ready");
+        return true;
+    }
 
+    // Inactive until on_activate; on_activate and on_deactivate switch them
+    // together. Kept as LifecyclePublisher: its publish() drops messages while
+    // inactive, which the base class one would not.
+    template<class M>
+    typename rclcpp_lifecycle::LifecyclePublisher<M>::SharedPtr managed_publisher(const std::string & topic, const rclcpp::QoS & qos){
+        auto publisher = create_publisher<M>(topic, qos);
+        managed_publishers.push_back(publisher);
+        return publisher;
+    }
 
-        this->action_server_set_tilt = rclcpp_action::create_server<SetTiltAction>(
-            this,
-            set_tilt_action_name,
-            std::bind(&HALFakePTU::handle_goal_tilt, this, std::placeholders::_1, std::placeholders::_2),
-            std::bind(&HALFakePTU::handle_cancel_tilt, this, std::placeholders::_1),
-            std::bind(&HALFakePTU::handle_accepted_tilt, this, std::placeholders::_1)
-        );
 
+    // Not managed: with simulation.publish_clock time keeps running while inactive
+    rclcpp_lifecycle::LifecyclePublisher<rosgraph_msgs::msg::Clock>::SharedPtr make_clock_publisher(){
+        auto publisher = create_publisher<rosgraph_msgs::msg::Clock>("/clock", 10);
+        publisher->on_activate();
+        return publisher;
+    }
 
-        this->action_server_set_pantilt = rclcpp_action::create_server<SetPanTiltAction>(
-            this,
-            set_pantilt_action_name,
-            std::bind(&HALFakePTU::handle_goal_pantilt, this, std::placeholders::_1, std::placeholders::_2),
-            std::bind(&HALFakePTU::handle_cancel_pantilt, this, std::placeholders::_1),
-            std::bind(&HALFakePTU::handle_accepted_pantilt, this, std::placeholders::_1)
-        );
 
-        hz = declare_parameter("hz", 10.0);
+    // Live-tunable settings, replaced as a whole so no reader sees half a change
+    struct Config {
+        double pan_min, pan_max, tilt_min, tilt_max;
+        std::array<hal_fake_ptu::AxisConfig, hal_fake_ptu::AXIS_COUNT> axes;
+        double internal_rate;
+        double hz;
+        double moving_hz, idle_hz;
+    };
+
+    // Written only by init and on_parameters, which ROS serializes
+    hal_fake_ptu::SeqLock<Config> config;
+    OnSetParametersCallbackHandle::SharedPtr parameters_handle;
+
+    // Derived from config, read by the ticks
+    std::atomic<int64_t> engine_period_ns;
+    std::atomic<int64_t> publish_period_ns;
+    int64_t sim_time_ns = 0;
+    int64_t next_publish_ns = 0;
+
+    bool adaptive_publishing;
+    std::atomic<int64_t> moving_period_ns;
+    std::atomic<int64_t> idle_period_ns;
+    bool intra_process;
+    bool publish_clock;
+    double speedup;
+
+    std::unique_ptr<hal_fake_ptu::MotionEngine> engine;
+
+    // Set when any axis model has effects; then the reported state is measured[unit]
+    std::unique_ptr<hal_fake_ptu::AxisModelBank> models;
+    std::vector<double> model_command;
+    std::vector<hal_fake_ptu::PTUState> model_ideal;
+    std::unique_ptr<hal_fake_ptu::SeqLock<hal_fake_ptu::PTUState>[]> measured;
+    int64_t model_stamp_ns = -1;
+    std::atomic<bool> models_reset{false};  // set by on_cleanup
+
+    struct TrackedGoal {
+        rclcpp_action::GoalUUID id;
+        hal_fake_ptu::AxisValues target;
+        bool running;
+    };
+
+    // Interfaces of one simulated PTU, named under its fleet namespace
+    struct Unit {
+        std::unique_ptr<hal_fake_ptu::GoalScheduler> scheduler;
+
+        rclcpp_lifecycle::LifecyclePublisher<ptu_interfaces::msg::PTU>::SharedPtr ptu_state_pub;
+
+        rclcpp::Subscription<std_msgs::msg::Float64>::SharedPtr pan_setpoint_sub;
+        rclcpp::Subscription<std_msgs::msg::Float64>::SharedPtr tilt_setpoint_sub;
+        rclcpp::Subscription<std_msgs::msg::Float64>::SharedPtr pan_velocity_sub;
+        rclcpp::Subscription<std_msgs::msg::Float64>::SharedPtr tilt_velocity_sub;
+
+        rclcpp::Service<ptu_interfaces::srv::SetPan>::SharedPtr set_pan_srv;
+        rclcpp::Service<ptu_interfaces::srv::SetTilt>::SharedPtr set_tilt_srv;
+        rclcpp::Service<ptu_interfaces::srv::SetPanTilt>::SharedPtr set_pantilt_srv;
+
+        rclcpp_action::Server<SetPanAction>::SharedPtr action_server_set_pan;
+        rclcpp_action::Server<SetTiltAction>::SharedPtr action_server_set_tilt;
+        rclcpp_action::Server<SetPanTiltAction>::SharedPtr action_server_set_pantilt;
+        rclcpp_action::Server<FollowWaypointsAction>::SharedPtr action_server_follow_waypoints;
+
+        rclcpp::Service<ptu_interfaces::srv::SetPanTiltSpeed>::SharedPtr set_pantilt_speed_srv;
+        rclcpp::Service<std_srvs::srv::Empty>::SharedPtr reset_srv;
+        rclcpp::Service<ptu_interfaces::srv::GetLimits>::SharedPtr get_limits_srv;
+        rclcpp::Service<hal_fake_ptu::srv::PredictPose>::SharedPtr predict_pose_srv;
+
+        // set_pantilt action goals from acceptance to their end, guarded by goals_mutex
+        std::vector<TrackedGoal> goals;
+
+        // Last reported motion state, to log only starts and stops
+        std::array<bool, hal_fake_ptu::AXIS_COUNT> moving{{false, false}};
+
+        // Reused for every state message when it cannot be loaned
+        ptu_interfaces::msg::PTU state_msg;
+        int64_t next_state_ns = 0;
+
+        rclcpp_lifecycle::LifecyclePublisher<sensor_msgs::msg::JointState>::SharedPtr joint_state_pub;
+        sensor_msgs::msg::JointState joint_state_msg;
+
+        std::unique_ptr<hal_fake_ptu::SerialProtocol> serial_protocol;
+        std::unique_ptr<hal_fake_ptu::PtyServer> serial;
+    };
+    std::vector<Unit> units;
+    std::mutex goals_mutex;
+
+    // Two transforms per unit, all sent in one message per tick
+    rclcpp_lifecycle::LifecyclePublisher<tf2_msgs::msg::TFMessage>::SharedPtr tf_pub;
+    tf2_msgs::msg::TFMessage tf_msg;
+
+    std::unique_ptr<hal_fake_ptu::TraceBuffer> trace;
+    std::unique_ptr<hal_fake_ptu::MappedLog> log;
+    std::unique_ptr<hal_fake_ptu::SharedStateWriter> shared_state;
+
+    // Set with faults.enabled: emulated faults, and the responses they delay
+    std::unique_ptr<hal_fake_ptu::FaultInjector> faults;
+    std::unique_ptr<hal_fake_ptu::TimerWheel> delayed;
+    // Stamp of the last engine tick, the time base of the faults
+    std::atomic<int64_t> engine_stamp_ns{0};
+
+    // Held by every recorded input from its record until the engine has it,
+    // and by the tick until its TICK record: inputs come from several
+    // callback groups, and an input logged ahead of TICK n is seen by tick n
+    std::mutex inputs_mutex;
+    // COMMAND records so far, their ordinals in CANCEL records
+    uint64_t commands_logged = 0;
+
+    std::unique_ptr<hal_fake_ptu::MappedLog> replay;
+    std::size_t replay_next = 0;
+    // Cancel flag of every replayed command, by COMMAND ordinal
+    std::vector<std::shared_ptr<std::atomic<bool>>> replay_canceled;
+    // Waypoints logged ahead of each unit's next COMMAND
+    std::vector<hal_fake_ptu::MoveCommand> replay_path;
+    std::string trace_file;
+    bool trace_on_shutdown;
+    rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr dump_trace_srv;
+
+    // Command paths whose latency is published, summed over every unit
+    enum Interface {
+        SET_PAN_SRV, SET_TILT_SRV, SET_PANTILT_SRV,
+        SET_PAN_ACTION, SET_TILT_ACTION, SET_PANTILT_ACTION, FOLLOW_WAYPOINTS_ACTION,
+        SETPOINT, SERIAL, INTERFACE_COUNT
+    };
+    // Interfaces with emulated faults, the ones before SETPOINT
+    static constexpr std::size_t FAULT_INTERFACES = SETPOINT;
+    // received -> motion started -> target reached -> response sent, and end to end
+    enum Stage { QUEUED, MOTION, REPLY, TOTAL, STAGE_COUNT };
+
+    std::array<std::array<hal_fake_ptu::LatencyHistogram, STAGE_COUNT>, INTERFACE_COUNT> latency;
+    hal_fake_ptu::LatencyHistogram tick_latency;
+    std::atomic<uint64_t> tick_overruns{0};
+    std::atomic<int64_t> tick_budget_ns{0};  // wall time one engine tick may take, 0 = unbounded
+    // Oldest setpoint not yet applied by a tick, steady clock ns (0 = none)
+    std::atomic<int64_t> setpoint_received_ns{0};
+
+    rclcpp_lifecycle::LifecyclePublisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub;
+    rclcpp_lifecycle::LifecyclePublisher<rosgraph_msgs::msg::Clock>::SharedPtr clock_pub;
+
+    // Lifecycle: init runs once, on the first configure. While inactive nothing
+    // is published and commands are refused, but the engine keeps ticking.
+    bool initialized = false;
+    bool configured = false;
+    std::atomic<bool> active{false};
+    std::vector<std::shared_ptr<rclcpp_lifecycle::LifecyclePublisherInterface>> managed_publishers;
+
+    rclcpp::CallbackGroup::SharedPtr publishing_group;
+    rclcpp::CallbackGroup::SharedPtr commands_group;
+    rclcpp::CallbackGroup::SharedPtr actions_group;
 
-        timer_ = this->create_wall_timer(1000ms / hz, std::bind(&HALFakePTU::spinCallback, this));
-      
-        RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Node Ready");
-        return true;
+    rclcpp::TimerBase::SharedPtr timer_;
+    rclcpp::TimerBase::SharedPtr engine_timer_;
+    rclcpp::TimerBase::SharedPtr diagnostics_timer_;
+    std::unique_ptr<hal_fake_ptu::TickThread> tick_thread;
+
+
+    // Empty when usable, otherwise what is wrong with it
+    static std::string check(const Config & candidate){
+        for (const auto & axis : candidate.axes) {
+            if (axis.speed <= 0.0 or axis.acceleration <= 0.0)
+                return "limits.*_speed and limits.*_acceleration must be positive";
+            if (axis.threshold < 0.0)
+                return "min_thresold_command_input_* must not be negative";
+        }
+        if (candidate.pan_min > candidate.pan_max or candidate.tilt_min > candidate.tilt_max)
+            return "limits.min_* must not exceed limits.max_*";
+        // Periods are whole nanoseconds: a rate above 1 GHz would make one of 0
+        auto valid_rate = [](double rate){ return rate > 0.0 and 1e9 / rate >= 1.0; };
+        if (not valid_rate(candidate.internal_rate) or not valid_rate(candidate.hz))
+            return "internal_rate and hz must be positive and at most 1e9";
+        if (not valid_rate(candidate.moving_hz) or not valid_rate(candidate.idle_hz))
+            return "publishing.moving_hz and publishing.idle_hz must be positive and at most 1e9";
+        return "";
     }
 
-    ~HALFakePTU(){
-        
+
+    // Validates the change as a whole, then hands the engine its new limits
+    // for the next tick and reschedules whatever runs at a changed rate.
+    rcl_interfaces::msg::SetParametersResult on_parameters(const std::vector<rclcpp::Parameter> & parameters){
+        rcl_interfaces::msg::SetParametersResult result;
+        const Config current = config.load();
+        Config next = current;
+        for (const rclcpp::Parameter & parameter : parameters) {
+            const std::string & name = parameter.get_name();
+            double * field = nullptr;
+            if (name == "limits.min_pan") field = &next.pan_min;
+            else if (name == "limits.max_pan") field = &next.pan_max;
+            else if (name == "limits.min_tilt") field = &next.tilt_min;
+            else if (name == "limits.max_tilt") field = &next.tilt_max;
+            else if (name == "limits.pan_speed") field = &next.axes[hal_fake_ptu::PAN].speed;
+            else if (name == "limits.tilt_speed") field = &next.axes[hal_fake_ptu::TILT].speed;
+            else if (name == "limits.pan_acceleration") field = &next.axes[hal_fake_ptu::PAN].acceleration;
+            else if (name == "limits.tilt_acceleration") field = &next.axes[hal_fake_ptu::TILT].acceleration;
+            else if (name == "min_thresold_command_input_pan") field = &next.axes[hal_fake_ptu::PAN].threshold;
+            else if (name == "min_thresold_command_input_tilt") field = &next.axes[hal_fake_ptu::TILT].threshold;
+            else if (name == "internal_rate") field = &next.internal_rate;
+            else if (name == "hz") field = &next.hz;
+            else if (name == "publishing.moving_hz") field = &next.moving_hz;
+            else if (name == "publishing.idle_hz") field = &next.idle_hz;
+            if (field)
+                *field = parameter.as_double();
+        }
+
+        result.reason = check(next);
+        if (result.reason.empty() and replay and next.internal_rate != current.internal_rate)
+            result.reason = "internal_rate is fixed by the log during replay";
+        result.successful = result.reason.empty();
+        if (not result.successful) {
+            RCLCPP_WARN_STREAM(get_logger(), "[FAKE PTU] Rejected parameter change: " << result.reason);
+            return result;
+        }
+        config.store(next);
+
+        bool axes_changed = false;
+        for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++) {
+            axes_changed |= next.axes[axis].speed != current.axes[axis].speed or
+                            next.axes[axis].acceleration != current.axes[axis].acceleration or
+                            next.axes[axis].threshold != current.axes[axis].threshold;
+        }
+        if (axes_changed)
+            engine->configure(next.axes);
+
+        moving_period_ns = static_cast<int64_t>(1e9 / next.moving_hz);
+        idle_period_ns = static_cast<int64_t>(1e9 / next.idle_hz);
+        if (next.internal_rate != current.internal_rate) {
+            engine_period_ns = static_cast<int64_t>(1e9 / next.internal_rate);
+            if (delayed)
+                delayed->set_resolution(engine_period_ns);
+            schedule_engine();
+        }
+        if (next.hz != current.hz) {
+            publish_period_ns = static_cast<int64_t>(1e9 / next.hz);
+            if (timer_)
+                schedule_publishing();
+        }
+        return result;
     }
 
 
- private:
-    double current_pan, current_tilt;
-    double default_velocity_;
+    // (Re)starts the engine tick at engine_period_ns; outside replay only
+    void schedule_engine(){
+        const int64_t period_ns = engine_period_ns;
+        if (tick_thread) {
+            tick_thread->set_period(period_ns);
+            tick_budget_ns = period_ns;
+        } else if (publish_clock) {
+            auto step_period = std::chrono::nanoseconds(speedup > 0.0 ? static_cast<int64_t>(period_ns / speedup) : 0);
+            tick_budget_ns = step_period.count();
+            engine_timer_ = this->create_wall_timer(step_period, std::bind(&HALFakePTU::stepCallback, this), publishing_group);
+        } else {
+            // Timers on the node clock follow /clock in lockstep when use_sim_time is set
+            tick_budget_ns = period_ns;
+            engine_timer_ = rclcpp::create_timer(this, get_clock(), rclcpp::Duration(std::chrono::nanoseconds(period_ns)),
+                                                 [this](){ engineCallback(now().nanoseconds()); }, publishing_group);
+        }
+    }
 
-    double pan_min, pan_max, tilt_min, tilt_max;
 
-    double pan_speed, tilt_speed;
-    double hz;
+    // (Re)starts the fixed-rate state timer at publish_period_ns
+    void schedule_publishing(){
+        timer_ = rclcpp::create_timer(this, get_clock(), rclcpp::Duration(std::chrono::nanoseconds(publish_period_ns.load())),
+                                      [this](){ spinCallback(now().nanoseconds()); }, publishing_group);
+    }
 
-    double min_step;
-    double internal_rate;
 
-    double min_threshold_to_move_pan, min_threshold_to_move_tilt;
-    
-    rclcpp::Publisher<ptu_interfaces::msg::PTU>::SharedPtr ptu_state_pub;
+    void get_limits_callback(const std::shared_ptr<ptu_interfaces::srv::GetLimits::Request>,
+            std::shared_ptr<ptu_interfaces::srv::GetLimits::Response> response){
+        const Config current = config.load();
+        response->pan_min = current.pan_min;
+        response->tilt_min = current.tilt_min;
+        response->pan_max = current.pan_max;
+        response->tilt_max = current.tilt_max;
+    }
 
-    rclcpp::Service<ptu_interfaces::srv::SetPan>::SharedPtr set_pan_srv;
-    rclcpp::Service<ptu_interfaces::srv::SetTilt>::SharedPtr set_tilt_srv;
-    rclcpp::Service<ptu_interfaces::srv::SetPanTilt>::SharedPtr set_pantilt_srv;
 
-    rclcpp_action::Server<SetPanAction>::SharedPtr action_server_set_pan;
-    rclcpp_action::Server<SetTiltAction>::SharedPtr action_server_set_tilt;
-    rclcpp_action::Server<SetPanTiltAction>::SharedPtr action_server_set_pantilt;
+    // Sampled from the planned motion, so the engine is never waited for. Axis
+    // model effects are not predicted. Queued goals are estimated as moves
+    // from rest at the current speed limits, one after the other.
+    void predict_pose_callback(std::size_t unit, const std::shared_ptr<hal_fake_ptu::srv::PredictPose::Request> request,
+            std::shared_ptr<hal_fake_ptu::srv::PredictPose::Response> response){
+        const rcl_clock_type_t clock_type = get_clock()->get_clock_type();
+        const int64_t now_ns = now().nanoseconds();
+        const std::size_t count = request->stamps.size();
+        std::vector<int64_t> stamps(count);
+        for (std::size_t i = 0; i < count; i++) {
+            const int64_t stamp_ns = rclcpp::Time(request->stamps[i], clock_type).nanoseconds();
+            stamps[i] = stamp_ns == 0 ? now_ns : stamp_ns;
+        }
+        std::vector<hal_fake_ptu::PTUState> predicted(count);
+        const int64_t rest_ns = std::max(engine->predict(unit, stamps.data(), count, predicted.data()), now_ns);
+
+        response->pan.resize(count);
+        response->tilt.resize(count);
+        response->pan_velocity.resize(count);
+        response->tilt_velocity.resize(count);
+        response->moving.resize(count);
+        for (std::size_t i = 0; i < count; i++) {
+            const hal_fake_ptu::PTUState & state = predicted[i];
+            response->pan[i] = state.position[hal_fake_ptu::PAN];
+            response->tilt[i] = state.position[hal_fake_ptu::TILT];
+            response->pan_velocity[i] = state.velocity[hal_fake_ptu::PAN];
+            response->tilt_velocity[i] = state.velocity[hal_fake_ptu::TILT];
+            response->moving[i] = state.moving[hal_fake_ptu::PAN] or state.moving[hal_fake_ptu::TILT];
+        }
+        response->at_rest = rclcpp::Time(rest_ns, clock_type);
 
-    rclcpp::Service<ptu_interfaces::srv::SetPanTiltSpeed>::SharedPtr set_pantilt_speed_srv;
-    rclcpp::Service<std_srvs::srv::Empty>::SharedPtr reset_srv;
-    rclcpp::Service<ptu_interfaces::srv::GetLimits>::SharedPtr get_limits_srv;
+        std::vector<TrackedGoal> goals;
+        {
+            std::lock_guard<std::mutex> lock(goals_mutex);
+            goals = units[unit].goals;
+        }
+        std::stable_partition(goals.begin(), goals.end(), [](const TrackedGoal & goal){ return goal.running; });
+
+        const Config current = config.load();
+        const hal_fake_ptu::PTUState at_rest = engine->sample(unit, rest_ns);
+        hal_fake_ptu::AxisValues from = at_rest.position;
+        int64_t end_ns = rest_ns;
+        response->goals.resize(goals.size());
+        for (std::size_t i = 0; i < goals.size(); i++) {
+            const TrackedGoal & goal = goals[i];
+            if (not goal.running) {
+                int64_t start_ns = end_ns;
+                for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++) {
+                    // As MotionEngine::plan_segment: an excursion of exactly the threshold is not moved
+                    if (std::abs(goal.target[axis] - from[axis]) <= current.axes[axis].threshold)
+                        continue;
+                    const hal_fake_ptu::AxisLimits limits{at_rest.speed[axis], current.axes[axis].acceleration};
+                    end_ns = std::max(end_ns, hal_fake_ptu::TrapezoidalProfile::plan({from[axis], 0.0}, goal.target[axis], limits, start_ns).end());
+                }
+            }
+            from = goal.target;
+            response->goals[i].goal_id = goal.id;
+            response->goals[i].running = goal.running;
+            response->goals[i].eta = rclcpp::Time(end_ns, clock_type);
+        }
+    }
 
-    rclcpp::TimerBase::SharedPtr timer_;
 
+    // Lists the goal in its unit from now until it ends, for predict_pose_callback
+    void track_goal(std::size_t unit, const rclcpp_action::GoalUUID & id, hal_fake_ptu::MoveCommand & command){
+        {
+            std::lock_guard<std::mutex> lock(goals_mutex);
+            units[unit].goals.push_back({id, command.target, false});
+        }
 
-    void get_limits_callback(const std::shared_ptr<ptu_interfaces::srv::GetLimits::Request>,
-            std::shared_ptr<ptu_interfaces::srv::GetLimits::Response> response){
-        response->pan_min= this->pan_min;
-        response->tilt_min = this->tilt_min;
-        response->pan_max = this->pan_max;
-        response->tilt_max = this->tilt_max;
+        auto on_start = std::move(command.on_start);
+        command.on_start = [this, unit, id, on_start](){
+            {
+                std::lock_guard<std::mutex> lock(goals_mutex);
+                for (auto & goal : units[unit].goals) {
+                    if (goal.id == id)
+                        goal.running = true;
+                }
+            }
+            if (on_start)
+                on_start();
+        };
+
+        auto on_done = std::move(command.on_done);
+        command.on_done = [this, unit, id, on_done](hal_fake_ptu::MoveStatus status){
+            {
+                std::lock_guard<std::mutex> lock(goals_mutex);
+                auto & goals = units[unit].goals;
+                goals.erase(std::remove_if(goals.begin(), goals.end(), [&id](const TrackedGoal & goal){ return goal.id == id; }), goals.end());
+            }
+            if (on_done)
+                on_done(status);
+        };
     }
 
 
-    void resetCallback(const std::shared_ptr<std_srvs::srv::Empty::Request>,
+    void resetCallback(std::size_t unit, const std::shared_ptr<std_srvs::srv::Empty::Request>,
             std::shared_ptr<std_srvs::srv::Empty::Response>){
-        current_pan = 0.0;
-        current_tilt = 0.0;
+        apply_reset(unit);
     }
 
 
-    void set_pan_callback(const std::shared_ptr<ptu_interfaces::srv::SetPan::Request> request,
-            std::shared_ptr<ptu_interfaces::srv::SetPan::Response>      response){
+    void set_pan_callback(std::size_t unit, const std::shared_ptr<rclcpp::Service<ptu_interfaces::srv::SetPan>> service,
+            const std::shared_ptr<rmw_request_id_t> request_header,
+            const std::shared_ptr<ptu_interfaces::srv::SetPan::Request> request){
 
-        double loop_time_sec = 1.0/internal_rate;
-        rclcpp::Rate loop_rate(internal_rate);
-        RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] set_pan_callback");
-                
-        if(abs(request->pan - current_pan) > min_threshold_to_move_pan)
-        {
-            double step;
-            while(1){
-                step = pan_speed * (request->pan - current_pan);
-                if (abs(step) < this->min_step)
-                {
-                    if (step > 0)
-                        step = this->min_step;
-                    else
-                        step = -1 * this->min_step;
-                }
+        hal_fake_ptu::MoveCommand command;
+        command.unit = unit;
+        command.active[hal_fake_ptu::PAN] = true;
+        command.target[hal_fake_ptu::PAN] = request->pan;
+        command.on_done = make_service_reply(service, request_header);
+        if (not admit_faults(SET_PAN_SRV)) {
+            command.on_done(hal_fake_ptu::MoveStatus::ABORTED);
+            return;
+        }
+        time_command(command, SET_PAN_SRV);
+        submit(std::move(command), false);
+    }
 
-                current_pan = current_pan + loop_time_sec * step;
 
-                RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] current_pan:  " << current_pan);
-                if(abs(request->pan - current_pan) < min_threshold_to_move_pan)
-                {
-                    break;
-                }
-               
-                loop_rate.sleep();
+    void set_tilt_callback(std::size_t unit, const std::shared_ptr<rclcpp::Service<ptu_interfaces::srv::SetTilt>> service,
+            const std::shared_ptr<rmw_request_id_t> request_header,
+            const std::shared_ptr<ptu_interfaces::srv::SetTilt::Request> request){
+
+        hal_fake_ptu::MoveCommand command;
+        command.unit = unit;
+        command.active[hal_fake_ptu::TILT] = true;
+        command.target[hal_fake_ptu::TILT] = request->tilt;
+        command.on_done = make_service_reply(service, request_header);
+        if (not admit_faults(SET_TILT_SRV)) {
+            command.on_done(hal_fake_ptu::MoveStatus::ABORTED);
+            return;
+        }
+        time_command(command, SET_TILT_SRV);
+        submit(std::move(command), false);
+    }
+
+
+    void set_pantilt_callback(std::size_t unit, const std::shared_ptr<rclcpp::Service<ptu_interfaces::srv::SetPanTilt>> service,
+            const std::shared_ptr<rmw_request_id_t> request_header,
+            const std::shared_ptr<ptu_interfaces::srv::SetPanTilt::Request> request){
+
+        hal_fake_ptu::MoveCommand command;
+        command.unit = unit;
+        command.active = {{true, true}};
+        command.target = {{request->pan, request->tilt}};
+        command.on_done = make_service_reply(service, request_header);
+        if (not admit_faults(SET_PANTILT_SRV)) {
+            command.on_done(hal_fake_ptu::MoveStatus::ABORTED);
+            return;
+        }
+        time_command(command, SET_PANTILT_SRV);
+        submit(std::move(command), false);
+    }
 
+
+    std::pair<double, double> range_of(hal_fake_ptu::Axis axis) const {
+        const Config current = config.load();
+        return axis == hal_fake_ptu::PAN ? std::make_pair(current.pan_min, current.pan_max) : std::make_pair(current.tilt_min, current.tilt_max);
+    }
+
+
+    void position_setpoint_callback(std::size_t unit, hal_fake_ptu::Axis axis, double position){
+        if (not active.load(std::memory_order_acquire) or not std::isfinite(position))
+            return;
+        const auto range = range_of(axis);
+        const double target = std::clamp(position, range.first, range.second);
+        apply_setpoint(unit, axis, target, std::numeric_limits<double>::infinity());
+    }
+
+
+    // Move towards the end of the range at that velocity, stopping there at the latest
+    void velocity_setpoint_callback(std::size_t unit, hal_fake_ptu::Axis axis, double velocity){
+        if (not active.load(std::memory_order_acquire) or not std::isfinite(velocity))
+            return;
+        const auto range = range_of(axis);
+        const double target = velocity >= 0.0 ? range.second : range.first;
+        apply_setpoint(unit, axis, target, std::abs(velocity));
+    }
+
+
+    static int64_t to_ns(SteadyClock::duration d) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    }
+
+
+    // Stamps the command when received, started, done and answered, with the
+    // interface's emulated faults in between, so a late response counts in
+    // REPLY and TOTAL. The intervals go to the histograms once it is out.
+    void time_command(hal_fake_ptu::MoveCommand & command, Interface interface){
+        struct Stamps {
+            SteadyClock::time_point received = SteadyClock::now();
+            SteadyClock::time_point started;
+            SteadyClock::time_point reached;
+        };
+        auto stamps = std::make_shared<Stamps>();
+
+        auto on_start = std::move(command.on_start);
+        command.on_start = [stamps, on_start](){
+            stamps->started = SteadyClock::now();
+            if (on_start)
+                on_start();
+        };
+
+        auto on_done = std::move(command.on_done);
+        command.on_done = [this, interface, stamps, on_done](hal_fake_ptu::MoveStatus status){
+            if (on_done)
+                on_done(status);
+            const SteadyClock::time_point sent = SteadyClock::now();
+
+            auto & histograms = latency[interface];
+            if (stamps->started != SteadyClock::time_point()) {
+                histograms[QUEUED].record(to_ns(stamps->started - stamps->received));
+                if (status == hal_fake_ptu::MoveStatus::SUCCEEDED)
+                    histograms[MOTION].record(to_ns(stamps->reached - stamps->started));
             }
+            histograms[REPLY].record(to_ns(sent - stamps->reached));
+            histograms[TOTAL].record(to_ns(sent - stamps->received));
+        };
+
+        if (interface < FAULT_INTERFACES)
+            emulate(command, interface);
+
+        // Done when the engine ends the move, before any emulated delay
+        auto respond = std::move(command.on_done);
+        command.on_done = [stamps, respond](hal_fake_ptu::MoveStatus status){
+            stamps->reached = SteadyClock::now();
+            respond(status);
+        };
+    }
+
+
+    // Services answer a refused request at once with ret false, actions reject the goal
+    bool admit_faults(Interface interface){
+        return not faults or not faults->enabled(interface) or faults->admit(interface);
+    }
+
+
+    // The interface's faults around an admitted command: stalls, lost or late
+    // feedback and late responses, all released from the engine tick and
+    // timed on its stamps
+    void emulate(hal_fake_ptu::MoveCommand & command, Interface interface){
+        if (not faults or not faults->enabled(interface))
+            return;
+
+        // A stall brakes the axes where they are, as a cancel would, and ends the move aborted
+        auto stalled = std::make_shared<bool>(false);
+        const int64_t stall_ns = faults->stall_ns(interface);
+        if (stall_ns >= 0) {
+            auto stall_at = std::make_shared<int64_t>(-1);
+            auto on_start = std::move(command.on_start);
+            command.on_start = [this, stall_at, stall_ns, on_start](){
+                *stall_at = engine_stamp_ns.load(std::memory_order_relaxed) + stall_ns;
+                if (on_start)
+                    on_start();
+            };
+            auto is_canceling = std::move(command.is_canceling);
+            command.is_canceling = [this, stall_at, stalled, is_canceling](){
+                if (is_canceling and is_canceling())
+                    return true;
+                if (*stall_at >= 0 and engine_stamp_ns.load(std::memory_order_relaxed) >= *stall_at)
+                    *stalled = true;
+                return *stalled;
+            };
         }
-        response->ret = true;
+
+        if (command.on_progress) {
+            auto on_progress = std::move(command.on_progress);
+            command.on_progress = [this, interface, on_progress](const hal_fake_ptu::AxisValues & progress){
+                if (faults->drop_feedback(interface))
+                    return;
+                if (faults->late_feedback(interface))
+                    delayed->schedule(engine_stamp_ns.load(std::memory_order_relaxed) + faults->latency_ns(interface), [on_progress, progress](){ on_progress(progress); });
+                else
+                    on_progress(progress);
+            };
+        }
+
+        auto on_done = std::move(command.on_done);
+        command.on_done = [this, interface, stalled, on_done](hal_fake_ptu::MoveStatus status){
+            faults->release(interface);
+            if (*stalled and status == hal_fake_ptu::MoveStatus::CANCELED)
+                status = hal_fake_ptu::MoveStatus::ABORTED;
+            const int64_t latency_ns = faults->latency_ns(interface);
+            if (latency_ns == 0) {
+                if (on_done)
+                    on_done(status);
+                return;
+            }
+            delayed->schedule(engine_stamp_ns.load(std::memory_order_relaxed) + latency_ns, [on_done, status](){
+                if (on_done)
+                    on_done(status);
+            });
+        };
     }
 
 
-    void set_tilt_callback(const std::shared_ptr<ptu_interfaces::srv::SetTilt::Request> request,
-            std::shared_ptr<ptu_interfaces::srv::SetTilt::Response>      response){
+    // Setpoints have no response: only received -> applied by a tick is timed
+    void stamp_setpoint(){
+        int64_t none = 0;
+        setpoint_received_ns.compare_exchange_strong(none, to_ns(SteadyClock::now().time_since_epoch()), std::memory_order_relaxed);
+    }
 
-        double loop_time_sec = 1.0/internal_rate;
-        rclcpp::Rate loop_rate(internal_rate);
-        
-        if(abs(request->tilt - current_tilt) > min_threshold_to_move_tilt)
-        {
-            double step;
-
-            while(1){
-                step = tilt_speed * (request->tilt - current_tilt);
-                if (abs(step) < this->min_step)
-                {
-                    if (step > 0)
-                        step = this->min_step;
-                    else
-                        step = -1 * this->min_step;
+
+    // To the trace ring and, when recording, to the log
+    void record(hal_fake_ptu::TraceEvent event, int64_t stamp_ns, std::size_t unit, uint16_t detail,
+                double value0 = 0.0, double value1 = 0.0){
+        trace->record(event, stamp_ns, unit, detail, value0, value1);
+        if (log)
+            log->append({stamp_ns, static_cast<uint32_t>(unit), static_cast<uint16_t>(event), detail, {value0, value1}});
+    }
+
+
+    // Records the command, the tick its cancel was seen at and how it ended.
+    // With inputs_mutex held: its waypoints stay ahead of its COMMAND and
+    // COMMAND records are in ordinal order.
+    void trace_command(hal_fake_ptu::MoveCommand & command, bool action){
+        if (not trace->enabled() and not log)
+            return;
+
+        const uint16_t axes = (command.active[hal_fake_ptu::PAN] ? 1 : 0) | (command.active[hal_fake_ptu::TILT] ? 2 : 0);
+        if (not command.waypoints.empty()) {
+            const int64_t stamp_ns = now().nanoseconds();
+            record(hal_fake_ptu::TraceEvent::TRAJECTORY, stamp_ns, command.unit, static_cast<uint16_t>(command.waypoints.size()), command.blend);
+            for (const auto & waypoint : command.waypoints) {
+                record(hal_fake_ptu::TraceEvent::WAYPOINT, stamp_ns, command.unit, 0,
+                       waypoint.target[hal_fake_ptu::PAN], waypoint.target[hal_fake_ptu::TILT]);
+                record(hal_fake_ptu::TraceEvent::WAYPOINT_VELOCITY, stamp_ns, command.unit, 0,
+                       waypoint.max_velocity[hal_fake_ptu::PAN], waypoint.max_velocity[hal_fake_ptu::TILT]);
+                record(hal_fake_ptu::TraceEvent::WAYPOINT_DURATION, stamp_ns, command.unit, 0, waypoint.duration_ns * 1e-9);
+            }
+        }
+        record(hal_fake_ptu::TraceEvent::COMMAND, now().nanoseconds(), command.unit, axes | (action ? hal_fake_ptu::TRACE_COMMAND_ACTION : 0),
+               command.target[hal_fake_ptu::PAN], command.target[hal_fake_ptu::TILT]);
+        const uint64_t ordinal = commands_logged++;
+
+        // Logged when the tick first sees it, so a replay cancels at the same tick
+        if (command.is_canceling) {
+            auto is_canceling = std::move(command.is_canceling);
+            auto logged = std::make_shared<bool>(false);
+            command.is_canceling = [this, unit = command.unit, ordinal, is_canceling, logged](){
+                const bool canceling = is_canceling();
+                if (canceling and not *logged) {
+                    *logged = true;
+                    record(hal_fake_ptu::TraceEvent::CANCEL, now().nanoseconds(), unit, 0, static_cast<double>(ordinal));
                 }
+                return canceling;
+            };
+        }
+
+        auto on_done = std::move(command.on_done);
+        command.on_done = [this, unit = command.unit, on_done](hal_fake_ptu::MoveStatus status){
+            record(hal_fake_ptu::TraceEvent::DONE, now().nanoseconds(), unit, static_cast<uint16_t>(status));
+            if (on_done)
+                on_done(status);
+        };
+    }
+
 
-                current_tilt = current_tilt + loop_time_sec * step;
+    // Every input that changes the simulation goes through these, live or replayed
 
-                RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] current_tilt:  " << current_tilt);
-                if(abs(request->tilt - current_tilt) < min_threshold_to_move_pan)
-                {
+    void submit(hal_fake_ptu::MoveCommand && command, bool action){
+        // Services and the serial port stay up while inactive, their moves end at once
+        if (not active.load(std::memory_order_acquire)) {
+            if (command.on_done)
+                command.on_done(hal_fake_ptu::MoveStatus::ABORTED);
+            return;
+        }
+        dispatch(std::move(command), action);
+    }
+
+
+    // submit() past the active check, for the node's own moves
+    void dispatch(hal_fake_ptu::MoveCommand && command, bool action){
+        std::lock_guard<std::mutex> lock(inputs_mutex);
+        trace_command(command, action);
+        if (action)
+            units[command.unit].scheduler->submit(std::move(command));
+        else
+            units[command.unit].scheduler->post(std::move(command));
+    }
+
+
+    // Serial commands go through the same entry points as the ROS ones, so they are traced and recorded too
+    hal_fake_ptu::SerialHandlers serial_handlers(std::size_t unit){
+        hal_fake_ptu::SerialHandlers handlers;
+        handlers.state = [this, unit](){ return state_of(unit, now().nanoseconds()); };
+        handlers.range = [this](hal_fake_ptu::Axis axis){ return range_of(axis); };
+        handlers.move = [this, unit](hal_fake_ptu::Axis axis, double target, std::function<void()> settled){
+            hal_fake_ptu::MoveCommand command;
+            command.unit = unit;
+            command.active[axis] = true;
+            command.target[axis] = target;
+            command.on_done = [settled](hal_fake_ptu::MoveStatus){ settled(); };
+            time_command(command, SERIAL);
+            submit(std::move(command), false);
+        };
+        handlers.set_speed = [this, unit](hal_fake_ptu::Axis axis, double speed){
+            const hal_fake_ptu::PTUState state = engine->snapshot(unit);
+            apply_speed(unit, axis == hal_fake_ptu::PAN ? speed : state.speed[hal_fake_ptu::PAN],
+                        axis == hal_fake_ptu::TILT ? speed : state.speed[hal_fake_ptu::TILT]);
+        };
+        // A move canceled from its first tick brakes the axis where it is
+        handlers.halt = [this, unit](hal_fake_ptu::Axis axis){
+            hal_fake_ptu::MoveCommand command;
+            command.unit = unit;
+            command.active[axis] = true;
+            command.target = engine->snapshot(unit).position;
+            command.is_canceling = [](){ return true; };
+            submit(std::move(command), false);
+        };
+        handlers.reset = [this, unit](){ apply_reset(unit); };
+        return handlers;
+    }
+
+
+    void apply_setpoint(std::size_t unit, hal_fake_ptu::Axis axis, double target, double max_velocity){
+        std::lock_guard<std::mutex> lock(inputs_mutex);
+        record(hal_fake_ptu::TraceEvent::SETPOINT, now().nanoseconds(), unit, axis, target, max_velocity);
+        stamp_setpoint();
+        engine->set_setpoint(unit, axis, target, max_velocity);
+    }
+
+
+    void apply_speed(std::size_t unit, double pan_speed, double tilt_speed){
+        std::lock_guard<std::mutex> lock(inputs_mutex);
+        record(hal_fake_ptu::TraceEvent::SPEED, now().nanoseconds(), unit, 0, pan_speed, tilt_speed);
+        engine->set_speed(unit, hal_fake_ptu::PAN, pan_speed);
+        engine->set_speed(unit, hal_fake_ptu::TILT, tilt_speed);
+    }
+
+
+    void apply_reset(std::size_t unit){
+        // Drop queued goals first, otherwise the aborted ones would hand their axes to them
+        std::lock_guard<std::mutex> lock(inputs_mutex);
+        record(hal_fake_ptu::TraceEvent::RESET, now().nanoseconds(), unit, 0);
+        units[unit].scheduler->clear();
+        engine->reset(unit);
+    }
+
+
+    // Applies logged inputs up to and including the next TICK. Commands
+    // replay without a client: no response, no feedback.
+    void replayCallback(){
+        if (not active.load(std::memory_order_acquire))
+            return;
+        while (replay_next < replay->size()) {
+            const hal_fake_ptu::TraceRecord & entry = (*replay)[replay_next++];
+            const std::size_t unit = entry.unit;
+            if (unit >= units.size()) {
+                // A placeholder keeps the ordinals of later commands in step for CANCEL
+                if (entry.event == static_cast<uint16_t>(hal_fake_ptu::TraceEvent::COMMAND))
+                    replay_canceled.push_back(nullptr);
+                continue;
+            }
+
+            switch (static_cast<hal_fake_ptu::TraceEvent>(entry.event)) {
+                case hal_fake_ptu::TraceEvent::TICK:
+                    advance(entry.stamp_ns);
+                    return;
+                case hal_fake_ptu::TraceEvent::COMMAND: {
+                    auto canceled = std::make_shared<std::atomic<bool>>(false);
+                    replay_canceled.push_back(canceled);
+                    hal_fake_ptu::MoveCommand command;
+                    command.unit = unit;
+                    command.active = {{(entry.detail & 1) != 0, (entry.detail & 2) != 0}};
+                    command.target = {{entry.value[0], entry.value[1]}};
+                    command.is_canceling = [canceled](){ return canceled->load(); };
+                    command.waypoints = std::move(replay_path[unit].waypoints);
+                    command.blend = replay_path[unit].blend;
+                    replay_path[unit] = hal_fake_ptu::MoveCommand();
+                    submit(std::move(command), (entry.detail & hal_fake_ptu::TRACE_COMMAND_ACTION) != 0);
                     break;
                 }
-               
-                loop_rate.sleep();
-
+                case hal_fake_ptu::TraceEvent::TRAJECTORY:
+                    replay_path[unit] = hal_fake_ptu::MoveCommand();
+                    replay_path[unit].blend = entry.value[0];
+                    break;
+                case hal_fake_ptu::TraceEvent::WAYPOINT:
+                    replay_path[unit].waypoints.emplace_back();
+                    replay_path[unit].waypoints.back().target = {{entry.value[0], entry.value[1]}};
+                    break;
+                case hal_fake_ptu::TraceEvent::WAYPOINT_VELOCITY:
+                    if (not replay_path[unit].waypoints.empty())
+                        replay_path[unit].waypoints.back().max_velocity = {{entry.value[0], entry.value[1]}};
+                    break;
+                case hal_fake_ptu::TraceEvent::WAYPOINT_DURATION:
+                    if (not replay_path[unit].waypoints.empty())
+                        replay_path[unit].waypoints.back().duration_ns = std::llround(entry.value[0] * 1e9);
+                    break;
+                case hal_fake_ptu::TraceEvent::CANCEL: {
+                    const std::size_t ordinal = static_cast<std::size_t>(entry.value[0]);
+                    if (ordinal < replay_canceled.size() and replay_canceled[ordinal])
+                        replay_canceled[ordinal]->store(true);
+                    break;
+                }
+                case hal_fake_ptu::TraceEvent::SETPOINT:
+                    apply_setpoint(unit, entry.detail == hal_fake_ptu::PAN ? hal_fake_ptu::PAN : hal_fake_ptu::TILT, entry.value[0], entry.value[1]);
+                    break;
+                case hal_fake_ptu::TraceEvent::SPEED:
+                    apply_speed(unit, entry.value[0], entry.value[1]);
+                    break;
+                case hal_fake_ptu::TraceEvent::RESET:
+                    apply_reset(unit);
+                    break;
+                default:  // outputs of the recorded run
+                    break;
             }
         }
-        
-        response->ret = true;
+
+        engine_timer_->cancel();
+        RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] Replay finished");
     }
 
 
-    void set_pantilt_callback(const std::shared_ptr<ptu_interfaces::srv::SetPanTilt::Request> request,
-            std::shared_ptr<ptu_interfaces::srv::SetPanTilt::Response>      response){
+    void dump_trace_callback(const std::shared_ptr<std_srvs::srv::Trigger::Request>,
+            std::shared_ptr<std_srvs::srv::Trigger::Response> response){
+        const long count = trace->dump(trace_file);
+        response->success = count >= 0;
+        response->message = count >= 0 ? std::to_string(count) + " records written to " + trace_file
+                                       : "cannot write " + trace_file;
+    }
 
-        double loop_time_sec = 1.0/internal_rate;
-        rclcpp::Rate loop_rate(internal_rate);
 
-        if(abs(request->pan - current_pan) > min_threshold_to_move_pan)
-        {
-            double step;
-            while(1){
-                step = pan_speed * (request->pan - current_pan);
-                if (abs(step) < this->min_step)
-                {
-                    if (step > 0)
-                        step = this->min_step;
-                    else
-                        step = -1 * this->min_step;
-                }
+    // The response is sent by the motion engine once the move ends,
+    // so the executor thread is released as soon as the target is posted.
+    template <typename ServiceT>
+    std::function<void(hal_fake_ptu::MoveStatus)> make_service_reply(
+        const std::shared_ptr<rclcpp::Service<ServiceT>> service,
+        const std::shared_ptr<rmw_request_id_t> request_header)
+    {
+        return [service, request_header](hal_fake_ptu::MoveStatus status){
+            typename ServiceT::Response response;
+            response.ret = status == hal_fake_ptu::MoveStatus::SUCCEEDED;
+            service->send_response(*request_header, response);
+        };
+    }
 
-                current_pan = current_pan + loop_time_sec * step;
-                RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] current_pan:  " << current_pan);
 
-                if(abs(request->pan - current_pan) < min_threshold_to_move_pan)
-                {
+    // fill, when given, completes the result before it is sent
+    template <typename ActionT>
+    std::function<void(hal_fake_ptu::MoveStatus)> make_goal_result(
+        const std::shared_ptr<rclcpp_action::ServerGoalHandle<ActionT>> goal_handle,
+        std::function<void(typename ActionT::Result &, hal_fake_ptu::MoveStatus)> fill = nullptr)
+    {
+        return [goal_handle, fill](hal_fake_ptu::MoveStatus status){
+            if (not rclcpp::ok())
+                return;
+
+            auto result = std::make_shared<typename ActionT::Result>();
+            result->ret = status == hal_fake_ptu::MoveStatus::SUCCEEDED;
+            if (fill)
+                fill(*result, status);
+            switch (status) {
+                case hal_fake_ptu::MoveStatus::SUCCEEDED:
+                    goal_handle->succeed(result);
                     break;
-                }
-               
-                loop_rate.sleep();
+                case hal_fake_ptu::MoveStatus::CANCELED:
+                    goal_handle->canceled(result);
+                    break;
+                case hal_fake_ptu::MoveStatus::ABORTED:
+                    goal_handle->abort(result);
+                    break;
+            }
+        };
+    }
 
+
+    // One step of simulated time: every motion and publishing decision is
+    // taken from sim_time_ns, so a run does not depend on how fast it goes.
+    void stepCallback(){
+        advance(sim_time_ns + engine_period_ns);
+    }
+
+
+    void advance(int64_t stamp_ns){
+        sim_time_ns = stamp_ns;
+
+        rosgraph_msgs::msg::Clock clock_msg;
+        clock_msg.clock = rclcpp::Time(sim_time_ns, RCL_ROS_TIME);
+        clock_pub->publish(clock_msg);
+
+        engineCallback(sim_time_ns);
+        if (not adaptive_publishing and sim_time_ns >= next_publish_ns) {
+            spinCallback(sim_time_ns);
+            next_publish_ns = sim_time_ns + publish_period_ns;
+        }
+    }
+
+
+    void engineCallback(int64_t stamp_ns){
+        const SteadyClock::time_point tick_start = SteadyClock::now();
+        const int64_t setpoint_received = setpoint_received_ns.exchange(0, std::memory_order_relaxed);
+        const bool publishing = active.load(std::memory_order_acquire);
+        engine_stamp_ns.store(stamp_ns, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> inputs(inputs_mutex);
+
+        for (auto & u : units)
+            u.scheduler->poll();
+        engine->tick(stamp_ns);
+        if (models)
+            step_models(stamp_ns);
+        if (delayed)
+            delayed->advance(stamp_ns);
+
+        if (setpoint_received != 0) {
+            const int64_t applied = to_ns(SteadyClock::now().time_since_epoch());
+            latency[SETPOINT][QUEUED].record(applied - setpoint_received);
+            latency[SETPOINT][TOTAL].record(applied - setpoint_received);
+        }
+
+        // Every step goes to the trace, only starts and stops are logged
+        static const char * const axis_name[hal_fake_ptu::AXIS_COUNT] = {"pan", "tilt"};
+        for (std::size_t unit = 0; unit < units.size(); unit++) {
+            Unit & u = units[unit];
+            const hal_fake_ptu::PTUState state = state_of(unit, stamp_ns);
+            bool changed = false;
+            for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++) {
+                if (state.moving[axis])
+                    record(hal_fake_ptu::TraceEvent::SAMPLE, stamp_ns, unit, axis, state.position[axis], state.velocity[axis]);
+                if (state.moving[axis] == u.moving[axis])
+                    continue;
+                changed = true;
+                u.moving[axis] = state.moving[axis];
+                RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] " << (units.size() > 1 ? "unit " + std::to_string(unit) + " " : "")
+                                   << axis_name[axis] << (state.moving[axis] ? " moving from " : " stopped at ") << state.position[axis]);
+            }
+
+            if (not publishing)
+                continue;
+
+            // Starts and stops (targets reached) go out at once, the rest at the rate for the motion state
+            if (adaptive_publishing and (changed or stamp_ns >= u.next_state_ns)) {
+                publish_state(u, state, rclcpp::Time(stamp_ns, get_clock()->get_clock_type()));
+                const bool moving = state.moving[hal_fake_ptu::PAN] or state.moving[hal_fake_ptu::TILT];
+                u.next_state_ns = stamp_ns + (moving ? moving_period_ns.load() : idle_period_ns.load());
             }
+            publish_joints(unit, state);
+            if (shared_state)
+                shared_state->write(unit, state);
         }
+        if (publishing and tf_pub)
+            tf_pub->publish(tf_msg);
 
-        if(abs(request->tilt - current_tilt) > min_threshold_to_move_tilt)
-        {
-            double step;
-            while(1){
-
-                step = tilt_speed * (request->tilt - current_tilt);
-                if (abs(step) < this->min_step)
-                {
-                    if (step > 0)
-                        step = this->min_step;
-                    else
-                        step = -1 * this->min_step;
-                }
+        // Inputs logged before this point were seen by this tick, later ones wait for the next
+        if (log) {
+            log->append({stamp_ns, 0, static_cast<uint16_t>(hal_fake_ptu::TraceEvent::TICK), 0, {0.0, 0.0}});
+            log->checkpoint();
+        }
 
-                current_tilt = current_tilt + loop_time_sec * step;
-                RCLCPP_INFO_STREAM(get_logger(), "[FAKE PTU] current_tilt:  " << current_tilt);
+        const int64_t tick_ns = to_ns(SteadyClock::now() - tick_start);
+        tick_latency.record(tick_ns);
+        if (tick_budget_ns > 0 and tick_ns > tick_budget_ns)
+            tick_overruns.fetch_add(1, std::memory_order_relaxed);
+    }
 
-                if(abs(request->tilt - current_tilt) < min_threshold_to_move_tilt)
-                {
-                    break;
-                }
-               
-                loop_rate.sleep();
 
+    // Joint state of the unit and its transforms in tf_msg, stamped with the
+    // instant the state was evaluated at
+    void publish_joints(std::size_t unit, const hal_fake_ptu::PTUState & state){
+        Unit & u = units[unit];
+        const rclcpp::Time stamp(state.stamp_ns, get_clock()->get_clock_type());
+        if (u.joint_state_pub) {
+            u.joint_state_msg.header.stamp = stamp;
+            for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++) {
+                u.joint_state_msg.position[axis] = state.position[axis];
+                u.joint_state_msg.velocity[axis] = state.velocity[axis];
             }
+            u.joint_state_pub->publish(u.joint_state_msg);
+        }
+        if (tf_pub) {
+            geometry_msgs::msg::TransformStamped & pan = tf_msg.transforms[unit * hal_fake_ptu::AXIS_COUNT];
+            geometry_msgs::msg::TransformStamped & tilt = tf_msg.transforms[unit * hal_fake_ptu::AXIS_COUNT + 1];
+            pan.header.stamp = stamp;
+            pan.transform.rotation.z = std::sin(0.5 * state.position[hal_fake_ptu::PAN]);
+            pan.transform.rotation.w = std::cos(0.5 * state.position[hal_fake_ptu::PAN]);
+            tilt.header.stamp = stamp;
+            tilt.transform.rotation.y = std::sin(0.5 * state.position[hal_fake_ptu::TILT]);
+            tilt.transform.rotation.w = std::cos(0.5 * state.position[hal_fake_ptu::TILT]);
         }
-        
-        response->ret = true;
     }
 
 
-    void set_pantilt_speed_callback(const std::shared_ptr<ptu_interfaces::srv::SetPanTiltSpeed::Request> request,
+    // Feeds the planned positions of every axis through the axis models
+    void step_models(int64_t stamp_ns){
+        if (models_reset.exchange(false, std::memory_order_acquire)) {
+            models->reset();
+            model_stamp_ns = -1;
+        }
+        const double dt = model_stamp_ns < 0 ? 0.0 : (stamp_ns - model_stamp_ns) * 1e-9;
+        model_stamp_ns = stamp_ns;
+
+        for (std::size_t unit = 0; unit < units.size(); unit++) {
+            model_ideal[unit] = engine->sample(unit, stamp_ns);
+            for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++)
+                model_command[unit * hal_fake_ptu::AXIS_COUNT + axis] = model_ideal[unit].position[axis];
+        }
+        models->step(model_command.data(), dt);
+
+        for (std::size_t unit = 0; unit < units.size(); unit++) {
+            hal_fake_ptu::PTUState state = model_ideal[unit];
+            for (int axis = 0; axis < hal_fake_ptu::AXIS_COUNT; axis++) {
+                state.position[axis] = models->position_of(unit * hal_fake_ptu::AXIS_COUNT + axis);
+                state.velocity[axis] = models->velocity_of(unit * hal_fake_ptu::AXIS_COUNT + axis);
+            }
+            measured[unit].store(state);
+        }
+    }
+
+
+    // What the unit reports: the plan at stamp_ns, or the model output of the
+    // last tick. Either way state.stamp_ns is the instant it describes.
+    hal_fake_ptu::PTUState state_of(std::size_t unit, int64_t stamp_ns) const {
+        if (models)
+            return measured[unit].load();
+        return engine->sample(unit, stamp_ns);
+    }
+
+
+    static void add_summary(diagnostic_msgs::msg::DiagnosticStatus & status, const std::string & prefix,
+                            const hal_fake_ptu::LatencySummary & summary){
+        auto add = [&status, &prefix](const char * key, int64_t ns){
+            char value[32];
+            std::snprintf(value, sizeof(value), "%.1f", ns * 1e-3);
+            diagnostic_msgs::msg::KeyValue entry;
+            entry.key = prefix + key;
+            entry.value = value;
+            status.values.push_back(entry);
+        };
+        add("p50_us", summary.p50_ns);
+        add("p99_us", summary.p99_ns);
+        add("max_us", summary.max_ns);
+    }
+
+
+    // Latency percentiles per interface and engine tick overruns since the last call
+    void diagnosticsCallback(){
+        if (not active.load(std::memory_order_acquire))
+            return;
+        static const char * const interface_name[INTERFACE_COUNT] = {
+            "set_pan service", "set_tilt service", "set_pantilt service",
+            "set_pan action", "set_tilt action", "set_pantilt action", "follow_waypoints action", "setpoints", "serial port"};
+        static const char * const stage_name[STAGE_COUNT] = {"queued_", "motion_", "reply_", "total_"};
+
+        diagnostic_msgs::msg::DiagnosticArray msg;
+        msg.header.stamp = now();
+
+        for (int interface = 0; interface < INTERFACE_COUNT; interface++) {
+            diagnostic_msgs::msg::DiagnosticStatus status;
+            status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+            status.name = std::string(get_name()) + ": " + interface_name[interface];
+            status.hardware_id = get_fully_qualified_name();
+
+            uint64_t count = 0;
+            for (int stage = 0; stage < STAGE_COUNT; stage++) {
+                const hal_fake_ptu::LatencySummary summary = latency[interface][stage].collect();
+                if (stage == TOTAL)
+                    count = summary.count;
+                add_summary(status, stage_name[stage], summary);
+            }
+            status.message = std::to_string(count) + " commands";
+            msg.status.push_back(status);
+        }
+
+        diagnostic_msgs::msg::DiagnosticStatus tick;
+        const uint64_t overruns = tick_overruns.exchange(0, std::memory_order_relaxed);
+        const hal_fake_ptu::LatencySummary summary = tick_latency.collect();
+        tick.level = overruns > 0 ? diagnostic_msgs::msg::DiagnosticStatus::WARN : diagnostic_msgs::msg::DiagnosticStatus::OK;
+        tick.name = std::string(get_name()) + ": engine tick";
+        tick.hardware_id = get_fully_qualified_name();
+        tick.message = std::to_string(overruns) + " of " + std::to_string(summary.count) + " ticks overran";
+        add_summary(tick, "", summary);
+        diagnostic_msgs::msg::KeyValue entry;
+        entry.key = "overruns";
+        entry.value = std::to_string(overruns);
+        tick.values.push_back(entry);
+        if (tick_thread) {
+            // How late the thread woke past each deadline, and deadlines dropped
+            add_summary(tick, "wakeup_", tick_thread->collect_jitter());
+            entry.key = "missed_deadlines";
+            entry.value = std::to_string(tick_thread->collect_missed());
+            tick.values.push_back(entry);
+        }
+        msg.status.push_back(tick);
+
+        diagnostics_pub->publish(msg);
+    }
+
+    void set_pantilt_speed_callback(std::size_t unit, const std::shared_ptr<ptu_interfaces::srv::SetPanTiltSpeed::Request> request,
             std::shared_ptr<ptu_interfaces::srv::SetPanTiltSpeed::Response>      response){
 
-        pan_speed = request->pan_speed;
-        tilt_speed = request->tilt_speed;
+        // A profile needs a positive velocity limit to ever reach its target
+        if (request->pan_speed <= 0.0 or request->tilt_speed <= 0.0) {
+            response->ret = false;
+            return;
+        }
+
+        apply_speed(unit, request->pan_speed, request->tilt_speed);
 
         response->ret = true;
     }
 
     
-    void spinCallback(){
-        // Publish Position & Speed
-        ptu_interfaces::msg::PTU ptu_msg;
-        ptu_msg.header.stamp = now();
-        ptu_msg.pan = current_pan;
-        ptu_msg.tilt = current_tilt;
-        ptu_msg.pan_speed = pan_speed;
-        ptu_msg.tilt_speed = tilt_speed;
-        ptu_state_pub->publish(ptu_msg);
+    void spinCallback(int64_t stamp_ns){
+        if (not active.load(std::memory_order_acquire))
+            return;
+        // Publish Position & Speed of every unit
+        for (std::size_t unit = 0; unit < units.size(); unit++) {
+            // Evaluated from the planned profiles, exact whatever hz is, unless axis models are on;
+            // then it is the measurement of the last tick, stamped as such
+            const hal_fake_ptu::PTUState state = state_of(unit, stamp_ns);
+            publish_state(units[unit], state, rclcpp::Time(state.stamp_ns, get_clock()->get_clock_type()));
+        }
+    }
+
+
+    void publish_state(Unit & u, const hal_fake_ptu::PTUState & state, const rclcpp::Time & stamp){
+        if (faults and faults->in_gap(stamp.nanoseconds()))
+            return;
+        auto fill = [&state, &stamp](ptu_interfaces::msg::PTU & ptu_msg){
+            ptu_msg.header.stamp = stamp;
+            ptu_msg.pan = state.position[hal_fake_ptu::PAN];
+            ptu_msg.tilt = state.position[hal_fake_ptu::TILT];
+            ptu_msg.pan_speed = state.speed[hal_fake_ptu::PAN];
+            ptu_msg.tilt_speed = state.speed[hal_fake_ptu::TILT];
+        };
+
+        if (intra_process) {
+            // Handed over as unique_ptr so intra-process subscribers get it without a copy
+            auto ptu_msg = std::make_unique<ptu_interfaces::msg::PTU>();
+            fill(*ptu_msg);
+            u.ptu_state_pub->publish(std::move(ptu_msg));
+        } else if (u.ptu_state_pub->can_loan_messages()) {
+            // Written straight into middleware memory
+            auto loaned = u.ptu_state_pub->borrow_loaned_message();
+            fill(loaned.get());
+            u.ptu_state_pub->publish(std::move(loaned));
+        } else {
+            fill(u.state_msg);
+            u.ptu_state_pub->publish(u.state_msg);
+        }
     }
 
 
     rclcpp_action::GoalResponse handle_goal_pan(
+        std::size_t unit,
         const rclcpp_action::GoalUUID & uuid,
         std::shared_ptr<const SetPanAction::Goal> goal)
     {
         (void)uuid;
         (void)goal;
+        if (not active.load(std::memory_order_acquire))
+            return rclcpp_action::GoalResponse::REJECT;
+        if (not units[unit].scheduler->admit({{true, false}}))
+            return rclcpp_action::GoalResponse::REJECT;
+        if (not admit_faults(SET_PAN_ACTION))
+            return rclcpp_action::GoalResponse::REJECT;
         return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
     }
 
@@ -348,73 +1871,39 @@ class HALFakePTU : public rclcpp::Node {
     }
 
 
-    void handle_accepted_pan(const std::shared_ptr<GoalHandlePanAction> goal_handle)
-    {
-        using namespace std::placeholders;
-        // this needs to return quickly to avoid blocking the executor, so spin up a new thread
-        std::thread{std::bind(&HALFakePTU::execute_pan_action, this, _1), goal_handle}.detach();
-    }
-
-
-    void execute_pan_action(const std::shared_ptr<GoalHandlePanAction> goal_handle)
+    void handle_accepted_pan(std::size_t unit, const std::shared_ptr<GoalHandlePanAction> goal_handle)
     {
-        double loop_time_sec = 1.0/internal_rate;
-        rclcpp::Rate loop_rate(internal_rate);
+        // this needs to return quickly to avoid blocking the executor, so hand the goal to the scheduler
         const auto goal = goal_handle->get_goal();
         auto feedback = std::make_shared<SetPanAction::Feedback>();
-        double perc_of_compl = 0.0;
-
-        auto result = std::make_shared<SetPanAction::Result>();
-
-        double excursion = abs(goal->pan - current_pan);
-        if(excursion > min_threshold_to_move_pan)
-        {
-            double step;
-            while(1){
-
-                step = pan_speed * (goal->pan - current_pan);
-                if (abs(step) < this->min_step)
-                {
-                    if (step > 0)
-                        step = this->min_step;
-                    else
-                        step = -1 * this->min_step;
-                }
-
-                current_pan = current_pan + loop_time_sec * step;
-
-                if (goal_handle->is_canceling()) {
-                    result->ret = false;
-                    goal_handle->canceled(result);
-                    return;
-                }
-
-                if(abs(goal->pan - current_pan) < min_threshold_to_move_pan)
-                {
-                    break;
-                }
-                perc_of_compl = 100.0 - ((abs(goal->pan - current_pan) / excursion * 100.0));
-                feedback->percentage_of_completing = perc_of_compl;
-                goal_handle->publish_feedback(feedback);
-                loop_rate.sleep();
 
-            }
-
-        }
-
-        if (rclcpp::ok()) {
-            result->ret = true;
-            goal_handle->succeed(result);
-        }
+        hal_fake_ptu::MoveCommand command;
+        command.unit = unit;
+        command.active[hal_fake_ptu::PAN] = true;
+        command.target[hal_fake_ptu::PAN] = goal->pan;
+        command.is_canceling = [goal_handle](){ return goal_handle->is_canceling(); };
+        command.on_progress = [goal_handle, feedback](const hal_fake_ptu::AxisValues & perc_of_compl){
+            feedback->percentage_of_completing = perc_of_compl[hal_fake_ptu::PAN];
+            goal_handle->publish_feedback(feedback);
+        };
+        command.on_done = make_goal_result<SetPanAction>(goal_handle);
+        time_command(command, SET_PAN_ACTION);
+        submit(std::move(command), true);
     }
 
-
     rclcpp_action::GoalResponse handle_goal_tilt(
+        std::size_t unit,
         const rclcpp_action::GoalUUID & uuid,
         std::shared_ptr<const SetTiltAction::Goal> goal)
     {
         (void)uuid;
         (void)goal;
+        if (not active.load(std::memory_order_acquire))
+            return rclcpp_action::GoalResponse::REJECT;
+        if (not units[unit].scheduler->admit({{false, true}}))
+            return rclcpp_action::GoalResponse::REJECT;
+        if (not admit_faults(SET_TILT_ACTION))
+            return rclcpp_action::GoalResponse::REJECT;
         return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
     }
 
@@ -427,75 +1916,39 @@ class HALFakePTU : public rclcpp::Node {
     }
 
 
-    void handle_accepted_tilt(const std::shared_ptr<GoalHandleTiltAction> goal_handle)
+    void handle_accepted_tilt(std::size_t unit, const std::shared_ptr<GoalHandleTiltAction> goal_handle)
     {
-        using namespace std::placeholders;
-        // this needs to return quickly to avoid blocking the executor, so spin up a new thread
-        std::thread{std::bind(&HALFakePTU::execute_tilt_action, this, _1), goal_handle}.detach();
-    }
-
-
-    void execute_tilt_action(const std::shared_ptr<GoalHandleTiltAction> goal_handle)
-    {
-        double loop_time_sec = 1.0/internal_rate;
-        rclcpp::Rate loop_rate(internal_rate);
+        // this needs to return quickly to avoid blocking the executor, so hand the goal to the scheduler
         const auto goal = goal_handle->get_goal();
         auto feedback = std::make_shared<SetTiltAction::Feedback>();
-        double perc_of_compl = 0.0;
-
-        auto result = std::make_shared<SetTiltAction::Result>();
-
-        double excursion = abs(goal->tilt - current_tilt);
-        if(excursion > min_threshold_to_move_tilt)
-        {
-            double step;
-            while(1){
-
-                step = tilt_speed * (goal->tilt - current_tilt);
-                if (abs(step) < this->min_step)
-                {
-                    if (step > 0)
-                        step = this->min_step;
-                    else
-                        step = -1 * this->min_step;
-                }
-
-                current_tilt = current_tilt + loop_time_sec * step;
-
-                if (goal_handle->is_canceling()) {
-                    result->ret = false;
-                    goal_handle->canceled(result);
-                    return;
-                }
-
-                if(abs(goal->tilt - current_tilt) < min_threshold_to_move_tilt)
-                {
-                    break;
-                }
 
-                perc_of_compl = 100.0 - (abs(goal->tilt - current_tilt) / excursion * 100.0);
-                feedback->percentage_of_completing = perc_of_compl;
-                goal_handle->publish_feedback(feedback);
-                loop_rate.sleep();
-
-            }
-
-        }
-
-        // Check if goal is done
-        if (rclcpp::ok()) {
-            result->ret = true;
-            goal_handle->succeed(result);
-        }
+        hal_fake_ptu::MoveCommand command;
+        command.unit = unit;
+        command.active[hal_fake_ptu::TILT] = true;
+        command.target[hal_fake_ptu::TILT] = goal->tilt;
+        command.is_canceling = [goal_handle](){ return goal_handle->is_canceling(); };
+        command.on_progress = [goal_handle, feedback](const hal_fake_ptu::AxisValues & perc_of_compl){
+            feedback->percentage_of_completing = perc_of_compl[hal_fake_ptu::TILT];
+            goal_handle->publish_feedback(feedback);
+        };
+        command.on_done = make_goal_result<SetTiltAction>(goal_handle);
+        time_command(command, SET_TILT_ACTION);
+        submit(std::move(command), true);
     }
 
-
     rclcpp_action::GoalResponse handle_goal_pantilt(
+        std::size_t unit,
         const rclcpp_action::GoalUUID & uuid,
         std::shared_ptr<const SetPanTiltAction::Goal> goal)
     {
         (void)uuid;
         (void)goal;
+        if (not active.load(std::memory_order_acquire))
+            return rclcpp_action::GoalResponse::REJECT;
+        if (not units[unit].scheduler->admit({{true, true}}))
+            return rclcpp_action::GoalResponse::REJECT;
+        if (not admit_faults(SET_PANTILT_ACTION))
+            return rclcpp_action::GoalResponse::REJECT;
         return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
     }
 
@@ -508,104 +1961,104 @@ class HALFakePTU : public rclcpp::Node {
     }
 
 
-    void handle_accepted_pantilt(const std::shared_ptr<GoalHandlePanTiltAction> goal_handle)
-    {
-        using namespace std::placeholders;
-        // this needs to return quickly to avoid blocking the executor, so spin up a new thread
-        std::thread{std::bind(&HALFakePTU::execute_pantilt_action, this, _1), goal_handle}.detach();
-    }
-    
-
-    void execute_pantilt_action(const std::shared_ptr<GoalHandlePanTiltAction> goal_handle)
+    void handle_accepted_pantilt(std::size_t unit, const std::shared_ptr<GoalHandlePanTiltAction> goal_handle)
     {
-        double loop_time_sec = 1.0/internal_rate;
-        rclcpp::Rate loop_rate(internal_rate);
+        // this needs to return quickly to avoid blocking the executor, so hand the goal to the scheduler
         const auto goal = goal_handle->get_goal();
         auto feedback = std::make_shared<SetPanTiltAction::Feedback>();
-        double perc_of_compl_pan = 0.0;
-        double perc_of_compl_tilt = 0.0;
-
-        auto result = std::make_shared<SetPanTiltAction::Result>();
-
-        double excursion_pan = abs(goal->pan - current_pan);
-        double excursion_tilt = abs(goal->tilt - current_tilt);
-        
-        if(excursion_pan > min_threshold_to_move_pan or excursion_tilt > min_threshold_to_move_tilt)
-        {
-            double step_pan, step_tilt;
-            while(1){
-                step_pan = loop_time_sec * (goal->pan - current_pan);
-                if (abs(step_pan) < this->min_step)
-                {
-                    if (step_pan > 0)
-                        step_pan = this->min_step;
-                    else
-                        step_pan = -1 * this->min_step;
-                }
-
-                step_tilt = loop_time_sec * (goal->tilt - current_tilt);
-                if (abs(step_tilt) < this->min_step)
-                {
-                    if (step_tilt > 0)
-                        step_tilt = this->min_step;
-                    else
-                        step_tilt = -1 * this->min_step;
-                }
-
-
-                if (goal_handle->is_canceling()) {
-                    result->ret = false;
-                    goal_handle->canceled(result);
-                    return;
-                }
 
-                if(abs(goal->tilt - current_tilt) >= min_threshold_to_move_tilt)
-                    current_tilt = current_tilt + tilt_speed * step_tilt;
-                
+        hal_fake_ptu::MoveCommand command;
+        command.unit = unit;
+        command.active = {{true, true}};
+        command.target = {{goal->pan, goal->tilt}};
+        command.is_canceling = [goal_handle](){ return goal_handle->is_canceling(); };
+        command.on_progress = [goal_handle, feedback](const hal_fake_ptu::AxisValues & perc_of_compl){
+            feedback->percentage_of_completing_pan = perc_of_compl[hal_fake_ptu::PAN];
+            feedback->percentage_of_completing_tilt = perc_of_compl[hal_fake_ptu::TILT];
+            goal_handle->publish_feedback(feedback);
+        };
+        command.on_done = make_goal_result<SetPanTiltAction>(goal_handle);
+        time_command(command, SET_PANTILT_ACTION);
+        track_goal(unit, goal_handle->get_goal_id(), command);
+        submit(std::move(command), true);
+    }
 
-                if(abs(goal->pan - current_pan) >= min_threshold_to_move_pan)
-                    current_pan = current_pan + pan_speed * step_pan;
+    rclcpp_action::GoalResponse handle_goal_waypoints(
+        std::size_t unit,
+        const rclcpp_action::GoalUUID & uuid,
+        std::shared_ptr<const FollowWaypointsAction::Goal> goal)
+    {
+        (void)uuid;
+        if (not active.load(std::memory_order_acquire))
+            return rclcpp_action::GoalResponse::REJECT;
+        // The trace counts waypoints in 16 bits
+        if (goal->waypoints.empty() or goal->waypoints.size() > std::numeric_limits<uint16_t>::max() or
+            not std::isfinite(goal->blend_radius))
+            return rclcpp_action::GoalResponse::REJECT;
+        for (const auto & waypoint : goal->waypoints) {
+            if (not std::isfinite(waypoint.pan) or not std::isfinite(waypoint.tilt) or not std::isfinite(waypoint.max_velocity))
+                return rclcpp_action::GoalResponse::REJECT;
+        }
+        if (not units[unit].scheduler->admit({{true, true}}))
+            return rclcpp_action::GoalResponse::REJECT;
+        if (not admit_faults(FOLLOW_WAYPOINTS_ACTION))
+            return rclcpp_action::GoalResponse::REJECT;
+        return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+    }
 
-                if(abs(goal->pan - current_pan) < min_threshold_to_move_pan and abs(goal->tilt - current_tilt) < min_threshold_to_move_tilt)
-                {
-                    break;
-                }
 
-                if (abs(goal->pan - current_pan) < min_threshold_to_move_pan)
-                    perc_of_compl_pan = 100.0;
-                else
-                    perc_of_compl_pan = 100.0 - (abs(goal->pan - current_pan) / excursion_pan * 100.0);
-                
-                if (abs(goal->tilt - current_tilt) < min_threshold_to_move_tilt)
-                    perc_of_compl_tilt = 100.0;
-                else
-                    perc_of_compl_tilt = 100.0 - (abs(goal->tilt - current_tilt) / excursion_tilt * 100.0);
-                
-                feedback->percentage_of_completing_pan = perc_of_compl_pan;
-                feedback->percentage_of_completing_tilt = perc_of_compl_tilt;
+    rclcpp_action::CancelResponse handle_cancel_waypoints(
+        const std::shared_ptr<GoalHandleWaypointsAction> goal_handle)
+    {
+        (void)goal_handle;
+        return rclcpp_action::CancelResponse::ACCEPT;
+    }
 
-                goal_handle->publish_feedback(feedback);
-                loop_rate.sleep();
 
+    void handle_accepted_waypoints(std::size_t unit, const std::shared_ptr<GoalHandleWaypointsAction> goal_handle)
+    {
+        // The whole pattern is one engine move, run back to back without a goal per point
+        const auto goal = goal_handle->get_goal();
+        auto feedback = std::make_shared<FollowWaypointsAction::Feedback>();
+        const std::size_t count = goal->waypoints.size();
+
+        hal_fake_ptu::MoveCommand command;
+        command.unit = unit;
+        command.active = {{true, true}};
+        command.blend = std::max(goal->blend_radius, 0.0);
+        command.waypoints.reserve(count);
+        int64_t previous_ns = 0;
+        for (const auto & point : goal->waypoints) {
+            hal_fake_ptu::Waypoint waypoint;
+            waypoint.target = {{point.pan, point.tilt}};
+            waypoint.max_velocity = {{point.max_velocity, point.max_velocity}};
+            const int64_t at_ns = rclcpp::Duration(point.time_from_start).nanoseconds();
+            if (at_ns > 0) {
+                waypoint.duration_ns = std::max<int64_t>(at_ns - previous_ns, 1);
+                previous_ns = at_ns;
             }
-
-        }
-
-        // Check if goal is done
-        if (rclcpp::ok()) {
-            result->ret = true;
-            goal_handle->succeed(result);
+            command.waypoints.push_back(waypoint);
         }
+        command.target = command.waypoints.back().target;
+
+        command.is_canceling = [goal_handle](){ return goal_handle->is_canceling(); };
+        command.on_segment = [feedback](std::size_t segment){ feedback->segment = static_cast<uint32_t>(segment); };
+        command.on_progress = [goal_handle, feedback, count](const hal_fake_ptu::AxisValues & perc_of_compl){
+            feedback->percentage_of_completing_segment = 0.5 * (perc_of_compl[hal_fake_ptu::PAN] + perc_of_compl[hal_fake_ptu::TILT]);
+            feedback->percentage_of_completing = (feedback->segment + feedback->percentage_of_completing_segment / 100.0) / count * 100.0;
+            goal_handle->publish_feedback(feedback);
+        };
+        command.on_done = make_goal_result<FollowWaypointsAction>(goal_handle,
+            [feedback, count](FollowWaypointsAction::Result & result, hal_fake_ptu::MoveStatus status){
+                result.completed = status == hal_fake_ptu::MoveStatus::SUCCEEDED ? static_cast<uint32_t>(count) : feedback->segment;
+            });
+        time_command(command, FOLLOW_WAYPOINTS_ACTION);
+        submit(std::move(command), true);
     }
 };
 
-int main(int argc, char **argv) {
-    rclcpp::init(argc, argv);
-    rclcpp::executors::MultiThreadedExecutor exec;
-    auto node = std::make_shared<HALFakePTU>();
-    if (not node->init()) rclcpp::shutdown();
-    exec.add_node(node);
-    exec.spin();
-    rclcpp::shutdown();
-    return 0;
+rclcpp_lifecycle::LifecycleNode::SharedPtr hal_fake_ptu::make_node(const rclcpp::NodeOptions & options) {
+    return std::make_shared<HALFakePTU>(options);
 }
+
+RCLCPP_COMPONENTS_REGISTER_NODE(HALFakePTU)
@@ -0,0 +1,58 @@
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+
+#if __has_include("rclcpp/experimental/executors/events_executor/events_executor.hpp")
+#include "rclcpp/experimental/executors/events_executor/events_executor.hpp"
+#define HAL_FAKE_PTU_EVENTS_EXECUTOR 1
+#endif
+
+#include "hal_fake_ptu/hal_fake_ptu.hpp"
+
+namespace {
+
+// From the node's executor.type and executor.threads (0 = one per core)
+std::unique_ptr<rclcpp::Executor> make_executor(const rclcpp_lifecycle::LifecycleNode & node) {
+    const std::string type = node.get_parameter("executor.type").as_string();
+    const auto threads = static_cast<std::size_t>(node.get_parameter("executor.threads").as_int());
+    auto logger = rclcpp::get_logger("hal_fake_ptu");
+
+    if (type == "single_threaded")
+        return std::make_unique<rclcpp::executors::SingleThreadedExecutor>();
+    if (type == "static_single_threaded")
+        return std::make_unique<rclcpp::executors::StaticSingleThreadedExecutor>();
+    if (type == "events") {
+#ifdef HAL_FAKE_PTU_EVENTS_EXECUTOR
+        return std::make_unique<rclcpp::experimental::executors::EventsExecutor>();
+#else
+        RCLCPP_WARN_STREAM(logger, "[FAKE PTU] No events executor in this ROS distribution, using static_single_threaded");
+        return std::make_unique<rclcpp::executors::StaticSingleThreadedExecutor>();
+#endif
+    }
+    RCLCPP_INFO_STREAM(logger, "[FAKE PTU] Multi-threaded executor, " << (threads > 0 ? std::to_string(threads) : "one per core") << " threads");
+    return std::make_unique<rclcpp::executors::MultiThreadedExecutor>(rclcpp::ExecutorOptions(), threads);
+}
+
+}  // namespace
+
+
+int main(int argc, char **argv) {
+    rclcpp::init(argc, argv);
+
+    rclcpp_lifecycle::LifecycleNode::SharedPtr node;
+    try {
+        node = hal_fake_ptu::make_node(rclcpp::NodeOptions());
+    } catch (const std::exception & e) {
+        RCLCPP_ERROR_STREAM(rclcpp::get_logger("hal_fake_ptu"), "[FAKE PTU] " << e.what());
+        rclcpp::shutdown();
+        return 1;
+    }
+
+    auto exec = make_executor(*node);
+    exec->add_node(node->get_node_base_interface());
+    exec->spin();
+    rclcpp::shutdown();
+    return 0;
+}
@@ -0,0 +1,69 @@
+#include "hal_fake_ptu/latency_histogram.hpp"
+
+#include <algorithm>
+
+namespace hal_fake_ptu {
+
+std::size_t LatencyHistogram::bucket_of(int64_t ns) {
+    uint64_t value = static_cast<uint64_t>(std::clamp<int64_t>(ns, 0, (int64_t{1} << MAX_BITS) - 1));
+    if (value < static_cast<uint64_t>(SUB_COUNT))
+        return static_cast<std::size_t>(value);
+
+    // Highest bit selects the range, the next SUB_BITS bits the bucket inside it:
+    // value >> shift is within [SUB_COUNT, 2 * SUB_COUNT), range shift + 1
+    const int msb = 63 - __builtin_clzll(value);
+    const int shift = msb - SUB_BITS;
+    return static_cast<std::size_t>(shift * SUB_COUNT + static_cast<int64_t>(value >> shift));
+}
+
+
+int64_t LatencyHistogram::upper_bound_of(std::size_t bucket) {
+    const int64_t index = static_cast<int64_t>(bucket);
+    if (index < SUB_COUNT)
+        return index;
+
+    // The inverse of bucket_of: the largest value landing in the bucket
+    const int shift = static_cast<int>(index / SUB_COUNT) - 1;
+    const int64_t sub = index % SUB_COUNT + SUB_COUNT;
+    return ((sub + 1) << shift) - 1;
+}
+
+
+void LatencyHistogram::record(int64_t ns) {
+    buckets[bucket_of(ns)].fetch_add(1, std::memory_order_relaxed);
+
+    int64_t current = max.load(std::memory_order_relaxed);
+    while (ns > current and not max.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+    }
+}
+
+
+LatencySummary LatencyHistogram::collect() {
+    std::array<uint64_t, BUCKETS> counts;
+    LatencySummary summary;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+        counts[i] = buckets[i].exchange(0, std::memory_order_relaxed);
+        summary.count += counts[i];
+    }
+    summary.max_ns = max.exchange(0, std::memory_order_relaxed);
+    if (summary.count == 0)
+        return summary;
+
+    const uint64_t p50_rank = (summary.count * 50 + 99) / 100;
+    const uint64_t p99_rank = (summary.count * 99 + 99) / 100;
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; i++) {
+        if (counts[i] == 0)
+            continue;
+        seen += counts[i];
+        if (summary.p50_ns == 0 and seen >= p50_rank)
+            summary.p50_ns = std::min(upper_bound_of(i), summary.max_ns);
+        if (seen >= p99_rank) {
+            summary.p99_ns = std::min(upper_bound_of(i), summary.max_ns);
+            break;
+        }
+    }
+    return summary;
+}
+
+}  // namespace hal_fake_ptu
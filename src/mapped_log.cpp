@@ -0,0 +1,123 @@
+#include "hal_fake_ptu/mapped_log.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace hal_fake_ptu {
+
+namespace {
+
+constexpr char MAGIC[8] = {'P', 'T', 'U', 'T', 'R', 'A', 'C', 'E'};
+
+[[noreturn]] void fail(const std::string & what, int fd = -1) {
+    const int error = errno;
+    if (fd >= 0)
+        ::close(fd);
+    throw std::system_error(error, std::generic_category(), what);
+}
+
+}  // namespace
+
+
+MappedLog::MappedLog(int fd, void * base, std::size_t bytes, std::size_t capacity, bool writable)
+    : fd(fd), base(base), bytes(bytes), capacity(capacity), writable(writable),
+      header(static_cast<TraceBuffer::TraceFileHeader *>(base)),
+      records(reinterpret_cast<TraceRecord *>(static_cast<char *>(base) + sizeof(TraceBuffer::TraceFileHeader))) {}
+
+
+std::unique_ptr<MappedLog> MappedLog::create(const std::string & path, std::size_t capacity) {
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        fail("cannot create " + path);
+
+    // Sparse until written, then never resized while recording
+    const std::size_t bytes = sizeof(TraceBuffer::TraceFileHeader) + capacity * sizeof(TraceRecord);
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+        fail("cannot size " + path, fd);
+    void * base = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+        fail("cannot map " + path, fd);
+
+    std::unique_ptr<MappedLog> log(new MappedLog(fd, base, bytes, capacity, true));
+    std::memcpy(log->header->magic, MAGIC, sizeof(MAGIC));
+    log->header->version = 1;
+    log->header->record_size = sizeof(TraceRecord);
+    log->header->count = 0;
+    return log;
+}
+
+
+std::unique_ptr<MappedLog> MappedLog::open(const std::string & path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        fail("cannot open " + path);
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+        fail("cannot stat " + path, fd);
+    const std::size_t bytes = static_cast<std::size_t>(info.st_size);
+    if (bytes < sizeof(TraceBuffer::TraceFileHeader)) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a PTU trace");
+    }
+
+    void * base = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+        fail("cannot map " + path, fd);
+
+    const std::size_t room = (bytes - sizeof(TraceBuffer::TraceFileHeader)) / sizeof(TraceRecord);
+    std::unique_ptr<MappedLog> log(new MappedLog(fd, base, bytes, room, false));
+    const TraceBuffer::TraceFileHeader & header = *log->header;
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 or header.version != 1 or
+        header.record_size != sizeof(TraceRecord) or header.count > room)
+        throw std::runtime_error(path + " is not a PTU trace");
+    log->next.store(static_cast<std::size_t>(header.count));
+    return log;
+}
+
+
+MappedLog::~MappedLog() {
+    const std::size_t count = size();
+    if (writable)
+        header->count = count;
+    ::munmap(base, bytes);
+
+    // Drop the unused tail; should that fail the header count still tells where the records end
+    if (writable) {
+        const bool trimmed = ::ftruncate(fd, static_cast<off_t>(sizeof(TraceBuffer::TraceFileHeader) + count * sizeof(TraceRecord))) == 0;
+        (void)trimmed;
+    }
+    ::close(fd);
+}
+
+
+bool MappedLog::append(const TraceRecord & record) {
+    const std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    if (index >= capacity) {
+        overflow.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    records[index] = record;
+    return true;
+}
+
+
+void MappedLog::checkpoint() {
+    if (writable)
+        header->count = size();
+}
+
+
+std::size_t MappedLog::size() const {
+    const std::size_t count = next.load(std::memory_order_relaxed);
+    return count < capacity ? count : capacity;
+}
+
+}  // namespace hal_fake_ptu
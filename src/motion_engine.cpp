@@ -0,0 +1,405 @@
+#include "hal_fake_ptu/motion_engine.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace hal_fake_ptu {
+
+MotionEngine::MotionEngine(std::size_t units, const std::array<AxisConfig, AXIS_COUNT> & axes)
+    : unit_count(units), axis_count(units * AXIS_COUNT),
+      max_velocity(axis_count), max_acceleration(axis_count), threshold(axis_count),
+      profile(axis_count), end_ns(axis_count, 0), settling(axis_count, 0), arrived(axis_count, 0),
+      replan(axis_count, 0), owner(axis_count), setpoint_seen(axis_count, 0), dirty(units, 0),
+      state(new SeqLock<Plan>[units]), setpoint(new SeqLock<Setpoint>[axis_count]) {
+    for (std::size_t unit = 0; unit < unit_count; unit++) {
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            max_velocity[index(unit, axis)] = axes[axis].speed;
+            max_acceleration[index(unit, axis)] = axes[axis].acceleration;
+            threshold[index(unit, axis)] = axes[axis].threshold;
+        }
+        publish_state(unit);
+    }
+    // The mailboxes start out holding a version of their own; only later writes are setpoints
+    for (std::size_t i = 0; i < axis_count; i++)
+        setpoint_seen[i] = setpoint[i].version();
+}
+
+
+void MotionEngine::post(MoveCommand && command) {
+    if (command.unit >= unit_count) {
+        if (command.on_done)
+            command.on_done(MoveStatus::ABORTED);
+        return;
+    }
+
+    auto move = std::make_shared<Move>();
+    move->command = std::move(command);
+    if (move->command.waypoints.empty()) {
+        Waypoint only;
+        only.target = move->command.target;
+        move->command.waypoints.push_back(only);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(move);
+}
+
+
+void MotionEngine::set_setpoint(std::size_t unit, Axis axis, double target, double max_velocity) {
+    if (unit >= unit_count)
+        return;
+
+    setpoint[index(unit, axis)].store({target, max_velocity});
+    setpoints_pending.store(true, std::memory_order_release);
+}
+
+
+void MotionEngine::configure(const std::array<AxisConfig, AXIS_COUNT> & axes) {
+    config.store(axes);
+    config_pending.store(true, std::memory_order_release);
+}
+
+
+void MotionEngine::apply_config() {
+    const std::array<AxisConfig, AXIS_COUNT> axes = config.load();
+    for (std::size_t unit = 0; unit < unit_count; unit++) {
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            const std::size_t i = index(unit, axis);
+            max_velocity[i] = axes[axis].speed;
+            max_acceleration[i] = axes[axis].acceleration;
+            threshold[i] = axes[axis].threshold;
+            replan[i] = 1;
+        }
+        dirty[unit] = 1;
+    }
+    replan_pending = true;
+}
+
+
+void MotionEngine::apply_setpoints(std::vector<Event> & events) {
+    for (std::size_t i = 0; i < axis_count; i++) {
+        uint64_t version;
+        const Setpoint next = setpoint[i].load(&version);
+        if (version == setpoint_seen[i])
+            continue;
+        setpoint_seen[i] = version;
+
+        // A streamed setpoint takes the axis over from any goal
+        if (owner[i]) {
+            std::shared_ptr<Move> previous = owner[i];
+            release(previous);
+            events.push_back({previous, Event::DONE, MoveStatus::ABORTED, progress_of(*previous, last_stamp_ns)});
+        }
+
+        const TrajectorySample now = profile[i].at(last_stamp_ns);
+        AxisLimits limits = limits_of(i);
+        limits.max_velocity = std::min(limits.max_velocity, next.max_velocity);
+        if (limits.max_velocity <= 0.0)
+            set_profile(i, TrapezoidalProfile::stop(now, limits, last_stamp_ns));
+        else
+            set_profile(i, TrapezoidalProfile::plan(now, next.target, limits, last_stamp_ns));
+        replan[i] = 0;
+    }
+}
+
+
+void MotionEngine::set_profile(std::size_t i, const TrapezoidalProfile & next) {
+    profile[i] = next;
+    end_ns[i] = next.end();
+    dirty[i / AXIS_COUNT] = 1;
+}
+
+
+void MotionEngine::adopt(const std::shared_ptr<Move> & move, std::vector<Event> & events) {
+    const std::size_t unit = move->command.unit;
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        if (not move->command.active[axis])
+            continue;
+        const std::size_t i = index(unit, axis);
+
+        // Supersede whatever is still running on this axis
+        if (owner[i]) {
+            std::shared_ptr<Move> previous = owner[i];
+            release(previous);
+            events.push_back({previous, Event::DONE, MoveStatus::ABORTED, progress_of(*previous, last_stamp_ns)});
+        }
+        owner[i] = move;
+    }
+    plan_segment(*move, last_stamp_ns);
+    moves.push_back(move);
+    events.push_back({move, Event::STARTED, MoveStatus::SUCCEEDED, {{0.0, 0.0}}});
+}
+
+
+void MotionEngine::plan_segment(Move & move, int64_t stamp_ns) {
+    const Waypoint & waypoint = move.waypoint();
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        if (not move.command.active[axis])
+            continue;
+        const std::size_t i = index(move.command.unit, axis);
+
+        const TrajectorySample now = profile[i].at(stamp_ns);
+        const double distance = std::abs(waypoint.target[axis] - now.position);
+        AxisLimits limits = limits_of(i);
+        if (waypoint.max_velocity[axis] > 0.0)
+            limits.max_velocity = std::min(limits.max_velocity, waypoint.max_velocity[axis]);
+
+        // Cruise velocity of the rest-to-rest profile lasting duration_ns, if the limits allow it
+        if (waypoint.duration_ns > 0) {
+            const double a = limits.max_acceleration;
+            const double t = waypoint.duration_ns * 1e-9;
+            const double discriminant = a * a * t * t - 4.0 * a * distance;
+            if (discriminant >= 0.0)
+                limits.max_velocity = std::min(limits.max_velocity, 0.5 * (a * t - std::sqrt(discriminant)));
+        }
+
+        move.excursion[axis] = distance;
+        move.reached[axis] = distance <= threshold[i];
+        if (move.reached[axis])
+            set_profile(i, TrapezoidalProfile::stop(now, limits, stamp_ns));
+        else
+            set_profile(i, TrapezoidalProfile::plan(now, waypoint.target[axis], limits, stamp_ns));
+        settling[i] = not move.reached[axis];
+        replan[i] = 0;
+    }
+}
+
+
+bool MotionEngine::within_blend(const Move & move, int64_t stamp_ns) const {
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        if (not move.command.active[axis] or move.reached[axis])
+            continue;
+        const std::size_t i = index(move.command.unit, axis);
+        if (std::abs(move.waypoint().target[axis] - profile[i].at(stamp_ns).position) > move.command.blend)
+            return false;
+    }
+    return true;
+}
+
+
+void MotionEngine::release(const std::shared_ptr<Move> & move) {
+    const std::size_t unit = move->command.unit;
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        const std::size_t i = index(unit, axis);
+        if (owner[i] == move) {
+            owner[i].reset();
+            settling[i] = 0;
+        }
+    }
+    moves.erase(std::remove(moves.begin(), moves.end(), move), moves.end());
+}
+
+
+AxisLimits MotionEngine::limits_of(std::size_t i) const {
+    return {max_velocity[i], max_acceleration[i]};
+}
+
+
+AxisValues MotionEngine::progress_of(const Move & move, int64_t stamp_ns) const {
+    AxisValues progress{{100.0, 100.0}};
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        if (move.reached[axis] or move.excursion[axis] <= 0.0)
+            continue;
+        const std::size_t i = index(move.command.unit, axis);
+        double error = std::abs(move.waypoint().target[axis] - profile[i].at(stamp_ns).position);
+        progress[axis] = 100.0 - (error / move.excursion[axis] * 100.0);
+    }
+    return progress;
+}
+
+
+void MotionEngine::tick(int64_t stamp_ns) {
+    // Reused from tick to tick, so a steady tick does not allocate
+    std::vector<Event> & events = tick_events;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        last_stamp_ns = stamp_ns;
+        const bool setpoints = setpoints_pending.exchange(false, std::memory_order_acquire);
+        const bool reconfigured = config_pending.exchange(false, std::memory_order_acquire);
+        if (pending.empty() and moves.empty() and not replan_pending and not setpoints and not reconfigured)
+            return;
+
+        // All limits change together, before anything is planned with them
+        if (reconfigured)
+            apply_config();
+
+        for (auto & move : pending)
+            adopt(move, events);
+        pending.clear();
+
+        if (setpoints)
+            apply_setpoints(events);
+
+        // Speed changed under a running move: continue from where the axis is now
+        if (replan_pending) {
+            for (std::size_t i = 0; i < axis_count; i++) {
+                if (not replan[i])
+                    continue;
+                replan[i] = 0;
+                if (settling[i])
+                    set_profile(i, TrapezoidalProfile::plan(profile[i].at(stamp_ns), profile[i].target(), limits_of(i), stamp_ns));
+            }
+            replan_pending = false;
+        }
+
+        // Branch-free scan of every axis of every unit
+        for (std::size_t i = 0; i < axis_count; i++)
+            arrived[i] = settling[i] & static_cast<uint8_t>(end_ns[i] <= stamp_ns);
+
+        for (std::size_t i = 0; i < axis_count; i++) {
+            if (not arrived[i])
+                continue;
+            owner[i]->reached[i % AXIS_COUNT] = true;
+            settling[i] = 0;
+        }
+
+        running.assign(moves.begin(), moves.end());
+        for (auto & move : running) {
+            if (move->command.is_canceling and move->command.is_canceling()) {
+                // Brake where the axes are instead of jumping to rest
+                for (int axis = 0; axis < AXIS_COUNT; axis++) {
+                    const std::size_t i = index(move->command.unit, axis);
+                    if (owner[i] == move)
+                        set_profile(i, TrapezoidalProfile::stop(profile[i].at(stamp_ns), limits_of(i), stamp_ns));
+                }
+                events.push_back({move, Event::DONE, MoveStatus::CANCELED, progress_of(*move, stamp_ns)});
+                release(move);
+            } else if (not move->last_segment() and
+                       (std::all_of(move->reached.begin(), move->reached.end(), [](bool r) { return r; }) or
+                        (move->command.blend > 0.0 and within_blend(*move, stamp_ns)))) {
+                // On to the next waypoint from wherever the axes are, at whatever speed
+                move->segment++;
+                plan_segment(*move, stamp_ns);
+                events.push_back({move, Event::SEGMENT, MoveStatus::SUCCEEDED, progress_of(*move, stamp_ns), move->segment});
+            } else if (std::all_of(move->reached.begin(), move->reached.end(), [](bool r) { return r; })) {
+                events.push_back({move, Event::DONE, MoveStatus::SUCCEEDED, progress_of(*move, stamp_ns)});
+                release(move);
+            } else {
+                events.push_back({move, Event::PROGRESS, MoveStatus::SUCCEEDED, progress_of(*move, stamp_ns)});
+            }
+        }
+
+        for (std::size_t unit = 0; unit < unit_count; unit++) {
+            if (dirty[unit])
+                publish_state(unit);
+        }
+    }
+
+    for (auto & event : events) {
+        const MoveCommand & command = event.move->command;
+        switch (event.kind) {
+            case Event::STARTED:
+                if (command.on_start)
+                    command.on_start();
+                break;
+            case Event::PROGRESS:
+                if (command.on_progress)
+                    command.on_progress(event.progress);
+                break;
+            case Event::SEGMENT:
+                if (command.on_segment)
+                    command.on_segment(event.segment);
+                break;
+            case Event::DONE:
+                if (command.on_done)
+                    command.on_done(event.status);
+                break;
+        }
+    }
+    // Drop the references now, not at the next tick
+    events.clear();
+    running.clear();
+}
+
+
+void MotionEngine::reset(std::size_t unit) {
+    if (unit >= unit_count)
+        return;
+
+    std::vector<std::shared_ptr<Move>> aborted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto of_unit = [unit](const std::shared_ptr<Move> & move) { return move->command.unit == unit; };
+
+        std::copy_if(moves.begin(), moves.end(), std::back_inserter(aborted), of_unit);
+        std::copy_if(pending.begin(), pending.end(), std::back_inserter(aborted), of_unit);
+        moves.erase(std::remove_if(moves.begin(), moves.end(), of_unit), moves.end());
+        pending.erase(std::remove_if(pending.begin(), pending.end(), of_unit), pending.end());
+
+        for (int axis = 0; axis < AXIS_COUNT; axis++) {
+            const std::size_t i = index(unit, axis);
+            owner[i].reset();
+            settling[i] = 0;
+            replan[i] = 0;
+            setpoint_seen[i] = setpoint[i].version();
+            set_profile(i, TrapezoidalProfile::hold(0.0, last_stamp_ns));
+        }
+        publish_state(unit);
+    }
+
+    for (auto & move : aborted) {
+        if (move->command.on_done)
+            move->command.on_done(MoveStatus::ABORTED);
+    }
+}
+
+
+void MotionEngine::set_speed(std::size_t unit, Axis axis, double speed) {
+    if (unit >= unit_count)
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::size_t i = index(unit, axis);
+    max_velocity[i] = speed;
+    replan[i] = 1;
+    replan_pending = true;
+    publish_state(unit);
+}
+
+
+void MotionEngine::publish_state(std::size_t unit) {
+    Plan plan;
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        plan.profile[axis] = profile[index(unit, axis)];
+        plan.speed[axis] = max_velocity[index(unit, axis)];
+    }
+    plan.stamp_ns = last_stamp_ns;
+    state[unit].store(plan);
+    dirty[unit] = 0;
+}
+
+
+PTUState MotionEngine::evaluate(const Plan & plan, int64_t stamp_ns) {
+    PTUState snapshot;
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        const TrajectorySample sample = plan.profile[axis].at(stamp_ns);
+        snapshot.position[axis] = sample.position;
+        snapshot.velocity[axis] = sample.velocity;
+        snapshot.speed[axis] = plan.speed[axis];
+        snapshot.moving[axis] = not plan.profile[axis].finished(stamp_ns);
+    }
+    snapshot.stamp_ns = stamp_ns;
+    return snapshot;
+}
+
+
+PTUState MotionEngine::snapshot(std::size_t unit, uint64_t * version) const {
+    const Plan plan = state[unit].load(version);
+    return evaluate(plan, plan.stamp_ns);
+}
+
+
+PTUState MotionEngine::sample(std::size_t unit, int64_t stamp_ns) const {
+    return evaluate(state[unit].load(), stamp_ns);
+}
+
+
+int64_t MotionEngine::predict(std::size_t unit, const int64_t * stamps, std::size_t count, PTUState * out) const {
+    const Plan plan = state[unit].load();
+    for (std::size_t i = 0; i < count; i++)
+        out[i] = evaluate(plan, stamps[i]);
+    return std::max(plan.profile[PAN].end(), plan.profile[TILT].end());
+}
+
+}  // namespace hal_fake_ptu
@@ -0,0 +1,216 @@
+#include "hal_fake_ptu/pty_server.hpp"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+namespace hal_fake_ptu {
+
+namespace {
+
+void close_fd(int & fd) {
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+}  // namespace
+
+
+PtyServer::PtyServer(SerialProtocol & protocol, const std::string & link, int64_t poll_ns)
+    : protocol(protocol), link(link), poll_ms(static_cast<int>(std::max<int64_t>(poll_ns / 1000000, 1))) {
+    auto fail = [this](const std::string & what) {
+        const int error = errno;
+        close_fd(wake);
+        close_fd(epoll);
+        close_fd(slave);
+        close_fd(master);
+        throw std::system_error(error, std::generic_category(), what);
+    };
+
+    master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master < 0 or grantpt(master) != 0 or unlockpt(master) != 0)
+        fail("cannot open a pseudo-terminal");
+    char name[128];
+    if (ptsname_r(master, name, sizeof(name)) != 0)
+        fail("ptsname");
+    slave_name = name;
+
+    // Raw: no echo, no line editing, no CR/LF translation on the driver's side
+    slave = ::open(name, O_RDWR | O_NOCTTY);
+    termios mode;
+    if (slave < 0 or tcgetattr(slave, &mode) != 0)
+        fail("cannot open " + slave_name);
+    cfmakeraw(&mode);
+    if (tcsetattr(slave, TCSANOW, &mode) != 0)
+        fail("cannot set " + slave_name + " to raw mode");
+
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll < 0 or wake < 0)
+        fail("epoll");
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, wake, &event) != 0)
+        fail("epoll_ctl");
+    event.events = watched = EPOLLIN;
+    event.data.fd = master;
+    if (epoll_ctl(epoll, EPOLL_CTL_ADD, master, &event) != 0)
+        fail("epoll_ctl");
+
+    // Only ever replaces a symlink, never a file
+    if (not link.empty()) {
+        struct stat existing;
+        if (lstat(link.c_str(), &existing) == 0) {
+            if (not S_ISLNK(existing.st_mode)) {
+                errno = EEXIST;
+                fail(link);
+            }
+            ::unlink(link.c_str());
+        }
+        if (::symlink(name, link.c_str()) != 0)
+            fail("cannot link " + link);
+    }
+
+    output.reserve(4 * BUFFER_SIZE);
+}
+
+
+PtyServer::~PtyServer() {
+    stop();
+    struct stat existing;
+    if (not link.empty() and lstat(link.c_str(), &existing) == 0 and S_ISLNK(existing.st_mode))
+        ::unlink(link.c_str());
+    close_fd(wake);
+    close_fd(epoll);
+    close_fd(slave);
+    close_fd(master);
+}
+
+
+void PtyServer::start() {
+    if (thread.joinable())
+        return;
+    running.store(true);
+    thread = std::thread(&PtyServer::run, this);
+}
+
+
+void PtyServer::stop() {
+    running.store(false);
+    const uint64_t one = 1;
+    if (wake >= 0) {
+        const ssize_t ignored = ::write(wake, &one, sizeof(one));
+        (void)ignored;
+    }
+    if (thread.joinable())
+        thread.join();
+}
+
+
+void PtyServer::run() {
+    epoll_event events[2];
+    while (running.load(std::memory_order_relaxed)) {
+        // Level triggered: no wake-ups at all while the port is quiet and nothing is awaited
+        const int count = epoll_wait(epoll, events, 2, protocol.awaiting() ? poll_ms : -1);
+        if (count < 0 and errno != EINTR)
+            break;
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.fd == wake) {
+                uint64_t value;
+                const ssize_t ignored = ::read(wake, &value, sizeof(value));
+                (void)ignored;
+            } else if (events[i].events & EPOLLIN) {
+                read_input();
+            }
+        }
+        process();
+        flush();
+    }
+}
+
+
+void PtyServer::read_input() {
+    while (filled < BUFFER_SIZE) {
+        const ssize_t count = ::read(master, input.data() + filled, BUFFER_SIZE - filled);
+        if (count > 0) {
+            filled += static_cast<std::size_t>(count);
+            bytes_in.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+        } else if (count < 0 and errno == EINTR) {
+            continue;
+        } else {
+            break;  // EAGAIN: drained
+        }
+    }
+}
+
+
+void PtyServer::process() {
+    for (;;) {
+        const std::size_t consumed = protocol.execute(std::string_view(input.data(), filled), output);
+        if (consumed > 0) {
+            std::memmove(input.data(), input.data() + consumed, filled - consumed);
+            filled -= consumed;
+        }
+        // The commands held back by an A run as soon as it is answered
+        if (not protocol.awaiting() or not protocol.poll(output))
+            break;
+    }
+
+    // A full buffer that is not waiting on an A holds one endless command
+    if (filled == BUFFER_SIZE and not protocol.awaiting()) {
+        output += "! Command too long\r\n";
+        filled = 0;
+    }
+}
+
+
+void PtyServer::flush() {
+    while (written < output.size()) {
+        const ssize_t count = ::write(master, output.data() + written, output.size() - written);
+        if (count >= 0) {
+            written += static_cast<std::size_t>(count);
+        } else if (errno == EAGAIN) {
+            break;
+        } else if (errno != EINTR) {
+            written = output.size();  // nowhere to send them
+            break;
+        }
+    }
+    if (written == output.size()) {
+        output.clear();
+        written = 0;
+    }
+
+    // Backed-up responses or a full buffer stop the reading until they drain
+    uint32_t events = 0;
+    if (not output.empty())
+        events |= EPOLLOUT;
+    if (output.size() - written < BUFFER_SIZE and filled < BUFFER_SIZE)
+        events |= EPOLLIN;
+    watch(events);
+}
+
+
+void PtyServer::watch(uint32_t events) {
+    if (events == watched)
+        return;
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = master;
+    if (epoll_ctl(epoll, EPOLL_CTL_MOD, master, &event) == 0)
+        watched = events;
+}
+
+}  // namespace hal_fake_ptu
@@ -0,0 +1,192 @@
+#include "hal_fake_ptu/serial_protocol.hpp"
+
+#include <charconv>
+#include <cmath>
+
+namespace hal_fake_ptu {
+
+namespace {
+
+constexpr double ARC_SECONDS_PER_RADIAN = 180.0 / M_PI * 3600.0;
+
+bool is_delimiter(char c) {
+    return c == ' ' or c == '\r' or c == '\n' or c == '\t';
+}
+
+char upper(char c) {
+    return (c >= 'a' and c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+}
+
+// Signed decimal filling the whole argument
+bool parse(std::string_view argument, long & value) {
+    if (not argument.empty() and argument.front() == '+')
+        argument.remove_prefix(1);
+    if (argument.empty())
+        return false;
+    const char * end = argument.data() + argument.size();
+    auto result = std::from_chars(argument.data(), end, value);
+    return result.ec == std::errc() and result.ptr == end;
+}
+
+const char * const LIMIT_ERROR[AXIS_COUNT] = {"! Pan limit\r\n", "! Tilt limit\r\n"};
+
+}  // namespace
+
+
+SerialProtocol::SerialProtocol(SerialHandlers handlers, double resolution)
+    : handlers(std::move(handlers)), resolution(resolution) {
+}
+
+
+std::size_t SerialProtocol::execute(std::string_view input, std::string & output) {
+    std::size_t consumed = 0;
+    while (not await_pending) {
+        std::size_t start = consumed;
+        while (start < input.size() and is_delimiter(input[start]))
+            start++;
+        std::size_t end = start;
+        while (end < input.size() and not is_delimiter(input[end]))
+            end++;
+
+        // Not terminated yet, the rest may still be on its way
+        if (end == input.size()) {
+            consumed = start;
+            break;
+        }
+
+        const std::string_view command = input.substr(start, end - start);
+        if (command.size() > MAX_COMMAND)
+            output += "! Command too long\r\n";
+        else
+            run(command, output);
+        consumed = end + 1;
+    }
+    return consumed;
+}
+
+
+bool SerialProtocol::poll(std::string & output) {
+    if (not await_pending or in_flight.load(std::memory_order_acquire) > 0)
+        return false;
+    const PTUState state = handlers.state();
+    if (state.moving[PAN] or state.moving[TILT])
+        return false;
+    await_pending = false;
+    output += "*\r\n";
+    return true;
+}
+
+
+void SerialProtocol::run(std::string_view command, std::string & output) {
+    const char first = upper(command[0]);
+    const char second = command.size() > 1 ? upper(command[1]) : '\0';
+
+    if (command.size() == 1 and first == 'A') {
+        await_pending = true;
+        poll(output);
+        return;
+    }
+    if (command.size() == 1 and first == 'R') {
+        handlers.reset();
+        output += "*\r\n";
+        return;
+    }
+    if (first == 'H' and command.size() <= 2) {
+        if (second == '\0' or second == 'P')
+            handlers.halt(PAN);
+        if (second == '\0' or second == 'T')
+            handlers.halt(TILT);
+        if (second == '\0' or second == 'P' or second == 'T') {
+            output += "*\r\n";
+            return;
+        }
+    }
+
+    if ((first == 'P' or first == 'T') and second != '\0') {
+        const Axis axis = first == 'P' ? PAN : TILT;
+        const std::string_view argument = command.substr(2);
+        switch (second) {
+            case 'P':
+                position(axis, argument, output);
+                return;
+            case 'S':
+                speed(axis, argument, output);
+                return;
+            case 'N':
+            case 'X':
+                if (argument.empty()) {
+                    const auto range = handlers.range(axis);
+                    reply(output, std::lround((second == 'N' ? range.first : range.second) / resolution));
+                    return;
+                }
+                break;
+            case 'R':
+                if (argument.empty()) {
+                    reply(output, resolution * ARC_SECONDS_PER_RADIAN);
+                    return;
+                }
+                break;
+        }
+    }
+    output += "! Illegal command\r\n";
+}
+
+
+void SerialProtocol::position(Axis axis, std::string_view argument, std::string & output) {
+    if (argument.empty()) {
+        reply(output, std::lround(handlers.state().position[axis] / resolution));
+        return;
+    }
+
+    long steps;
+    if (not parse(argument, steps)) {
+        output += "! Illegal argument\r\n";
+        return;
+    }
+    const double target = steps * resolution;
+    const auto range = handlers.range(axis);
+    if (target < range.first or target > range.second) {
+        output += LIMIT_ERROR[axis];
+        return;
+    }
+
+    in_flight.fetch_add(1, std::memory_order_relaxed);
+    handlers.move(axis, target, [this]() { in_flight.fetch_sub(1, std::memory_order_release); });
+    output += "*\r\n";
+}
+
+
+void SerialProtocol::speed(Axis axis, std::string_view argument, std::string & output) {
+    if (argument.empty()) {
+        reply(output, std::lround(handlers.state().speed[axis] / resolution));
+        return;
+    }
+
+    long steps;
+    if (not parse(argument, steps) or steps <= 0) {
+        output += "! Illegal argument\r\n";
+        return;
+    }
+    handlers.set_speed(axis, steps * resolution);
+    output += "*\r\n";
+}
+
+
+void SerialProtocol::reply(std::string & output, long value) const {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    output += "* ";
+    output.append(digits, result.ptr);
+    output += "\r\n";
+}
+
+
+void SerialProtocol::reply(std::string & output, double value) const {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 4);
+    output += "* ";
+    output.append(digits, result.ptr);
+    output += "\r\n";
+}
+
+}  // namespace hal_fake_ptu
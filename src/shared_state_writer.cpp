@@ -0,0 +1,73 @@
+#include "hal_fake_ptu/shared_state_writer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <system_error>
+
+namespace hal_fake_ptu {
+
+std::unique_ptr<SharedStateWriter> SharedStateWriter::create(const std::string & name, std::size_t units) {
+    // A fresh segment, so readers of a previous run keep their own copy instead of seeing this one half built
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), name);
+
+    const std::size_t bytes = shared_state_bytes(units);
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        const int error = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), name);
+    }
+    void * base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        throw std::system_error(error, std::generic_category(), name);
+    }
+
+    auto * header = static_cast<SharedStateHeader *>(base);
+    header->version = SHARED_STATE_VERSION;
+    header->units = static_cast<uint32_t>(units);
+    header->slot_bytes = sizeof(SharedStateSlot);
+    auto * slots = static_cast<SharedStateSlot *>(base) + 1;
+    for (std::size_t unit = 0; unit < units; unit++)
+        new (&slots[unit]) SharedStateSlot();
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, SHARED_STATE_MAGIC, sizeof(SHARED_STATE_MAGIC));
+
+    return std::unique_ptr<SharedStateWriter>(new SharedStateWriter(name, base, bytes));
+}
+
+
+SharedStateWriter::SharedStateWriter(const std::string & name, void * base, std::size_t bytes)
+    : name(name), base(base), bytes(bytes), slots(static_cast<SharedStateSlot *>(base) + 1) {
+}
+
+
+SharedStateWriter::~SharedStateWriter() {
+    munmap(base, bytes);
+    shm_unlink(name.c_str());
+}
+
+
+void SharedStateWriter::write(std::size_t unit, const PTUState & state) {
+    SharedPose pose;
+    pose.stamp_ns = state.stamp_ns;
+    for (int axis = 0; axis < AXIS_COUNT; axis++) {
+        pose.position[axis] = state.position[axis];
+        pose.velocity[axis] = state.velocity[axis];
+        pose.moving[axis] = state.moving[axis] ? 1 : 0;
+    }
+    slots[unit].pose.store(pose);
+}
+
+}  // namespace hal_fake_ptu
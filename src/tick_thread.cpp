@@ -0,0 +1,129 @@
+#include "hal_fake_ptu/tick_thread.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace hal_fake_ptu {
+
+namespace {
+
+int64_t monotonic_ns() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void sleep_until(int64_t deadline_ns) {
+    timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadline_ns / 1000000000);
+    deadline.tv_nsec = static_cast<long>(deadline_ns % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+}
+
+int policy_from_string(const std::string & name) {
+    if (name == "other")
+        return SCHED_OTHER;
+    if (name == "fifo")
+        return SCHED_FIFO;
+    if (name == "rr")
+        return SCHED_RR;
+    throw std::invalid_argument("unknown scheduling policy '" + name + "', expected other, fifo or rr");
+}
+
+}  // namespace
+
+
+TickThread::TickThread(const TickThreadConfig & config, std::function<void()> tick)
+    : config(config), policy(policy_from_string(config.policy)), tick(std::move(tick)), period_ns(config.period_ns) {
+    if (config.period_ns <= 0)
+        throw std::invalid_argument("tick period must be positive");
+}
+
+
+TickThread::~TickThread() {
+    stop();
+}
+
+
+std::vector<std::string> TickThread::start() {
+    std::vector<std::string> failed;
+    if (thread.joinable())
+        return failed;
+
+    if (config.lock_memory and mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        failed.push_back(std::string("mlockall: ") + std::strerror(errno));
+
+    running.store(true);
+    released.store(false);
+    thread = std::thread(&TickThread::run, this);
+
+    // Applied before the first tick, the thread waits to be released
+    if (config.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(config.cpu, &cpus);
+        int error = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus);
+        if (error != 0)
+            failed.push_back("affinity to CPU " + std::to_string(config.cpu) + ": " + std::strerror(error));
+    }
+    if (policy != SCHED_OTHER) {
+        sched_param param{};
+        param.sched_priority = config.priority;
+        int error = pthread_setschedparam(thread.native_handle(), policy, &param);
+        if (error != 0)
+            failed.push_back("policy " + config.policy + " priority " + std::to_string(config.priority) + ": " + std::strerror(error));
+    }
+
+    released.store(true, std::memory_order_release);
+    return failed;
+}
+
+
+void TickThread::stop() {
+    running.store(false);
+    released.store(true, std::memory_order_release);
+    if (thread.joinable())
+        thread.join();
+}
+
+
+void TickThread::set_period(int64_t period) {
+    if (period <= 0)
+        throw std::invalid_argument("tick period must be positive");
+    period_ns.store(period, std::memory_order_relaxed);
+}
+
+
+void TickThread::run() {
+    while (not released.load(std::memory_order_acquire))
+        std::this_thread::yield();
+
+    int64_t deadline_ns = monotonic_ns();
+    while (running.load(std::memory_order_relaxed)) {
+        const int64_t period = period_ns.load(std::memory_order_relaxed);
+        deadline_ns += period;
+        sleep_until(deadline_ns);
+        if (not running.load(std::memory_order_relaxed))
+            break;
+
+        jitter.record(monotonic_ns() - deadline_ns);
+        tick();
+
+        // Deadlines already behind us are skipped, not caught up on
+        const int64_t late_ns = monotonic_ns() - deadline_ns;
+        if (late_ns >= period) {
+            const int64_t skipped = late_ns / period;
+            missed.fetch_add(static_cast<uint64_t>(skipped), std::memory_order_relaxed);
+            deadline_ns += skipped * period;
+        }
+    }
+}
+
+}  // namespace hal_fake_ptu
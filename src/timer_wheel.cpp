@@ -0,0 +1,87 @@
+#include "hal_fake_ptu/timer_wheel.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace hal_fake_ptu {
+
+TimerWheel::TimerWheel(int64_t resolution_ns, std::size_t slots)
+    : resolution_ns(resolution_ns), wheel(slots) {
+    if (resolution_ns <= 0 or slots == 0)
+        throw std::invalid_argument("timer wheel resolution and slots must be positive");
+}
+
+
+void TimerWheel::schedule(int64_t due_ns, Callback callback) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Never behind the cursor, where advance() would not look until a turn later
+    const int64_t tick = std::max(due_ns / resolution_ns, cursor);
+    slot_of(tick).push_back({due_ns, std::move(callback)});
+    count++;
+}
+
+
+void TimerWheel::advance(int64_t now_ns) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const int64_t now_tick = now_ns / resolution_ns;
+        // Slots are visited once at most, however far time jumped
+        const int64_t slots = static_cast<int64_t>(wheel.size());
+        int64_t first = cursor;
+        if (cursor == std::numeric_limits<int64_t>::min() or now_tick - cursor >= slots)
+            first = now_tick - slots + 1;
+
+        for (int64_t tick = first; tick <= now_tick and count > 0; tick++) {
+            std::vector<Entry> & slot = slot_of(tick);
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < slot.size(); i++) {
+                if (slot[i].due_ns <= now_ns)
+                    due.push_back(std::move(slot[i]));
+                else if (kept++ != i)
+                    slot[kept - 1] = std::move(slot[i]);
+            }
+            count -= slot.size() - kept;
+            slot.resize(kept);
+        }
+        // The current tick is visited again next time, for what is due later within it
+        cursor = std::max(cursor, now_tick);
+    }
+
+    // In due order, and in scheduling order when due together
+    std::stable_sort(due.begin(), due.end(), [](const Entry & a, const Entry & b){ return a.due_ns < b.due_ns; });
+    for (Entry & entry : due)
+        entry.callback();
+    due.clear();
+}
+
+
+std::size_t TimerWheel::pending() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+
+void TimerWheel::set_resolution(int64_t next_ns) {
+    if (next_ns <= 0)
+        throw std::invalid_argument("timer wheel resolution must be positive");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (next_ns == resolution_ns)
+        return;
+
+    std::vector<Entry> moved;
+    moved.reserve(count);
+    for (std::vector<Entry> & slot : wheel) {
+        for (Entry & entry : slot)
+            moved.push_back(std::move(entry));
+        slot.clear();
+    }
+    // The tick of the first stamp not fully visited yet, at the new resolution
+    if (cursor != std::numeric_limits<int64_t>::min())
+        cursor = cursor * resolution_ns / next_ns;
+    resolution_ns = next_ns;
+    for (Entry & entry : moved)
+        slot_of(std::max(entry.due_ns / resolution_ns, cursor)).push_back(std::move(entry));
+}
+
+}  // namespace hal_fake_ptu
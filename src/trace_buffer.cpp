@@ -0,0 +1,91 @@
+#include "hal_fake_ptu/trace_buffer.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace hal_fake_ptu {
+
+namespace {
+
+std::size_t ring_size(std::size_t capacity) {
+    std::size_t size = 1;
+    while (size < capacity)
+        size <<= 1;
+    return size;
+}
+
+}  // namespace
+
+
+TraceBuffer::TraceBuffer(std::size_t capacity)
+    : mask(capacity == 0 ? SIZE_MAX : ring_size(capacity) - 1),
+      slots(capacity == 0 ? nullptr : new Slot[ring_size(capacity)]) {
+    // Touch every slot now so recording never faults a page in
+    if (enabled()) {
+        for (std::size_t i = 0; i <= mask; i++) {
+            for (auto & word : slots[i].words)
+                word.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+
+void TraceBuffer::record(TraceEvent event, int64_t stamp_ns, std::size_t unit, uint16_t detail,
+                         double value0, double value1) {
+    if (not enabled())
+        return;
+
+    const TraceRecord record{stamp_ns, static_cast<uint32_t>(unit), static_cast<uint16_t>(event), detail, {value0, value1}};
+    uint64_t words_in[WORDS];
+    std::memcpy(words_in, &record, sizeof(record));
+
+    const uint64_t index = head.fetch_add(1, std::memory_order_relaxed);
+    Slot & slot = slots[index & mask];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < WORDS; i++)
+        slot.words[i].store(words_in[i], std::memory_order_relaxed);
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+
+long TraceBuffer::dump(const std::string & path) const {
+    std::vector<TraceRecord> records;
+    if (enabled()) {
+        const uint64_t end = head.load(std::memory_order_acquire);
+        const uint64_t capacity = mask + 1;
+        const uint64_t begin = end > capacity ? end - capacity : 0;
+        records.reserve(end - begin);
+
+        for (uint64_t index = begin; index < end; index++) {
+            const Slot & slot = slots[index & mask];
+            uint64_t words_out[WORDS];
+            const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            for (std::size_t i = 0; i < WORDS; i++)
+                words_out[i] = slot.words[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            // Skip records still being written or already overwritten
+            if (before != 2 * index + 2 or slot.sequence.load(std::memory_order_relaxed) != before)
+                continue;
+
+            TraceRecord record;
+            std::memcpy(&record, words_out, sizeof(record));
+            records.push_back(record);
+        }
+    }
+
+    std::FILE * file = std::fopen(path.c_str(), "wb");
+    if (not file)
+        return -1;
+
+    TraceFileHeader header{{'P', 'T', 'U', 'T', 'R', 'A', 'C', 'E'}, 1, sizeof(TraceRecord), records.size()};
+    bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+    if (ok and not records.empty())
+        ok = std::fwrite(records.data(), sizeof(TraceRecord), records.size(), file) == records.size();
+    ok = std::fclose(file) == 0 and ok;
+    return ok ? static_cast<long>(records.size()) : -1;
+}
+
+}  // namespace hal_fake_ptu
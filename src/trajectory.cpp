@@ -0,0 +1,108 @@
+#include "hal_fake_ptu/trajectory.hpp"
+
+#include <cmath>
+
+namespace hal_fake_ptu {
+
+TrapezoidalProfile TrapezoidalProfile::hold(double position, int64_t start_ns) {
+    TrapezoidalProfile profile;
+    profile.start_ns = start_ns;
+    profile.p_end = position;
+    profile.close();
+    return profile;
+}
+
+
+TrapezoidalProfile TrapezoidalProfile::plan(const TrajectorySample & start, double target,
+                                            const AxisLimits & limits, int64_t start_ns) {
+    const double max_v = limits.max_velocity;
+    const double max_a = limits.max_acceleration;
+    if (max_v <= 0.0 or max_a <= 0.0)
+        return hold(start.position, start_ns);
+
+    TrapezoidalProfile profile;
+    profile.start_ns = start_ns;
+    profile.p_end = start.position;
+    profile.v_end = start.velocity;
+
+    // Moving away from the target, or unable to stop before it: brake to rest first
+    double distance = target - profile.p_end;
+    double speed = std::abs(profile.v_end);
+    if (speed > 0.0 and (profile.v_end * distance < 0.0 or speed * speed / (2.0 * max_a) > std::abs(distance))) {
+        profile.append(speed / max_a, profile.v_end > 0.0 ? -max_a : max_a);
+        profile.v_end = 0.0;
+    }
+
+    distance = target - profile.p_end;
+    if (distance != 0.0) {
+        const double dir = distance > 0.0 ? 1.0 : -1.0;
+        const double u0 = dir * profile.v_end;
+
+        // Reach the cruise velocity, or the peak of a triangular profile
+        double peak = std::sqrt((2.0 * max_a * std::abs(distance) + u0 * u0) / 2.0);
+        if (peak > max_v)
+            peak = max_v;
+        profile.append(std::abs(peak - u0) / max_a, peak >= u0 ? dir * max_a : -dir * max_a);
+
+        double cruise = std::abs(target - profile.p_end) - peak * peak / (2.0 * max_a);
+        if (cruise > 0.0)
+            profile.append(cruise / peak, 0.0);
+
+        profile.append(peak / max_a, -dir * max_a);
+    }
+
+    profile.p_end = target;
+    profile.v_end = 0.0;
+    profile.close();
+    return profile;
+}
+
+
+TrapezoidalProfile TrapezoidalProfile::stop(const TrajectorySample & start, const AxisLimits & limits, int64_t start_ns) {
+    if (start.velocity == 0.0 or limits.max_acceleration <= 0.0)
+        return hold(start.position, start_ns);
+
+    TrapezoidalProfile profile;
+    profile.start_ns = start_ns;
+    profile.p_end = start.position;
+    profile.v_end = start.velocity;
+    profile.append(std::abs(start.velocity) / limits.max_acceleration,
+                   start.velocity > 0.0 ? -limits.max_acceleration : limits.max_acceleration);
+    profile.v_end = 0.0;
+    profile.close();
+    return profile;
+}
+
+
+void TrapezoidalProfile::append(double duration, double acceleration) {
+    if (duration <= 0.0 or count == MAX_SEGMENTS)
+        return;
+
+    segments[count++] = {t_end, p_end, v_end, acceleration};
+    p_end += v_end * duration + 0.5 * acceleration * duration * duration;
+    v_end += acceleration * duration;
+    t_end += duration;
+}
+
+
+void TrapezoidalProfile::close() {
+    goal = p_end;
+    end_ns = start_ns + static_cast<int64_t>(std::ceil(t_end * 1e9));
+}
+
+
+TrajectorySample TrapezoidalProfile::at(int64_t stamp_ns) const {
+    if (stamp_ns >= end_ns or count == 0)
+        return {goal, 0.0};
+
+    double t = stamp_ns > start_ns ? (stamp_ns - start_ns) * 1e-9 : 0.0;
+    int i = count - 1;
+    while (i > 0 and segments[i].t0 > t)
+        i--;
+
+    const Segment & segment = segments[i];
+    double dt = t - segment.t0;
+    return {segment.p0 + segment.v0 * dt + 0.5 * segment.a * dt * dt, segment.v0 + segment.a * dt};
+}
+
+}  // namespace hal_fake_ptu
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "hal_fake_ptu/axis_model.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+constexpr double DT = 0.01;
+
+// Steps a single axis model towards command for seconds
+double settle(AxisModelBank & bank, double command, double seconds) {
+    for (int i = 0; i < static_cast<int>(seconds / DT); i++)
+        bank.step(&command, DT);
+    return bank.position_of(0);
+}
+
+AxisModelBank single(const AxisModelConfig & config, unsigned effects) {
+    return AxisModelBank({config}, {effects});
+}
+
+}  // namespace
+
+
+TEST(AxisModel, NoEffectsFollowsTheCommand) {
+    AxisModelBank bank = single({}, 0);
+    double command = 0.3;
+    bank.step(&command, DT);
+    EXPECT_EQ(bank.position_of(0), 0.3);
+    EXPECT_NEAR(bank.velocity_of(0), 30.0, 1e-9);
+}
+
+
+TEST(AxisModel, QuantizationRoundsToTheResolution) {
+    AxisModelConfig config;
+    config.resolution = 0.01;
+    AxisModelBank bank = single(config, QUANTIZATION);
+    double command = 0.1234;
+    bank.step(&command, DT);
+    EXPECT_NEAR(bank.position_of(0), 0.12, 1e-12);
+}
+
+
+TEST(AxisModel, LagApproachesTheCommand) {
+    AxisModelConfig config;
+    config.lag = 0.1;
+    AxisModelBank bank = single(config, LAG);
+    EXPECT_LT(settle(bank, 1.0, 0.1), 0.7);
+    EXPECT_NEAR(settle(bank, 1.0, 2.0), 1.0, 1e-6);
+}
+
+
+// The node's first step has no elapsed time
+TEST(AxisModel, ZeroLagFollowsFromTheFirstStep) {
+    AxisModelConfig config;
+    config.lag = 0.0;
+    AxisModelBank bank = single(config, LAG);
+    double command = 0.3;
+    bank.step(&command, 0.0);
+    EXPECT_EQ(bank.position_of(0), 0.3);
+    EXPECT_EQ(settle(bank, 0.5, 0.1), 0.5);
+}
+
+
+TEST(AxisModel, BacklashLeavesPlayOnReversal) {
+    AxisModelConfig config;
+    config.backlash = 0.02;
+    AxisModelBank bank = single(config, BACKLASH);
+    EXPECT_NEAR(settle(bank, 0.5, DT), 0.49, 1e-12);
+    // Coming back, the output does not move until the play is taken up
+    EXPECT_NEAR(settle(bank, 0.485, DT), 0.49, 1e-12);
+    EXPECT_NEAR(settle(bank, 0.4, DT), 0.41, 1e-12);
+}
+
+
+TEST(AxisModel, SaturationLimitsVelocityWithoutOvershoot) {
+    AxisModelConfig config;
+    config.max_velocity = 0.5;
+    config.max_acceleration = 2.0;
+    AxisModelBank bank = single(config, SATURATION);
+    double peak = 0.0;
+    double command = 1.0;
+    for (int i = 0; i < 500; i++) {
+        bank.step(&command, DT);
+        EXPECT_LE(std::abs(bank.velocity_of(0)), 0.5 + 1e-9);
+        peak = std::max(peak, bank.position_of(0));
+    }
+    EXPECT_NEAR(bank.position_of(0), 1.0, 1e-3);
+    EXPECT_LT(peak, 1.0 + 1e-3);
+}
+
+
+TEST(AxisModel, NoiseIsSeededAndCentered) {
+    AxisModelConfig config;
+    config.noise = 0.01;
+    config.seed = 7;
+    AxisModelBank a({config, config}, {NOISE, NOISE});
+    config.seed = 8;
+    AxisModelBank b({config}, {NOISE});
+
+    double commands[2] = {0.0, 0.0};
+    double sum = 0.0, sum_sq = 0.0;
+    bool differs = false;
+    for (int i = 0; i < 10000; i++) {
+        a.step(commands, DT);
+        b.step(commands, DT);
+        EXPECT_EQ(a.position_of(0), a.position_of(1));
+        differs = differs or a.position_of(0) != b.position_of(0);
+        sum += a.position_of(0);
+        sum_sq += a.position_of(0) * a.position_of(0);
+    }
+    EXPECT_TRUE(differs);
+    EXPECT_NEAR(sum / 10000, 0.0, 0.001);
+    EXPECT_NEAR(std::sqrt(sum_sq / 10000), 0.01, 0.001);
+}
+
+
+// Cleanup between scenarios: the same commands give the same readings again
+TEST(AxisModel, ResetRestartsFromConstruction) {
+    AxisModelConfig config;
+    config.lag = 0.1;
+    config.backlash = 0.02;
+    config.noise = 0.01;
+    config.seed = 3;
+    AxisModelBank bank = single(config, LAG | BACKLASH | NOISE);
+    const double first = settle(bank, 1.0, 0.2);
+    settle(bank, -1.0, 1.0);
+
+    bank.reset();
+    EXPECT_EQ(bank.position_of(0), 0.0);
+    EXPECT_EQ(bank.velocity_of(0), 0.0);
+    EXPECT_EQ(settle(bank, 1.0, 0.2), first);
+}
+
+
+TEST(AxisModel, ParsesEffectNames) {
+    EXPECT_EQ(axis_effects_from_strings({"lag", "quantization"}), static_cast<unsigned>(LAG | QUANTIZATION));
+    EXPECT_EQ(axis_effects_from_strings({}), 0u);
+    EXPECT_THROW(axis_effects_from_strings({"friction"}), std::invalid_argument);
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "hal_fake_ptu/fault_injector.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+double mean_latency(FaultInjector & faults, int draws) {
+    double sum = 0.0;
+    for (int i = 0; i < draws; i++)
+        sum += faults.latency_ns(0) * 1e-9;
+    return sum / draws;
+}
+
+}  // namespace
+
+
+TEST(FaultInjector, ParsesDistributionNames) {
+    EXPECT_EQ(latency_distribution_from_string("constant"), LatencyDistribution::CONSTANT);
+    EXPECT_EQ(latency_distribution_from_string("lognormal"), LatencyDistribution::LOGNORMAL);
+    EXPECT_THROW(latency_distribution_from_string("pareto"), std::invalid_argument);
+}
+
+
+TEST(FaultInjector, NothingHappensUnconfigured) {
+    FaultInjector faults(2, 1);
+    EXPECT_FALSE(faults.enabled(0));
+    for (int i = 0; i < 1000; i++) {
+        ASSERT_EQ(faults.latency_ns(0), 0);
+        ASSERT_FALSE(faults.drop_feedback(0));
+        ASSERT_TRUE(faults.admit(0));
+        ASSERT_LT(faults.stall_ns(0), 0);
+        ASSERT_FALSE(faults.in_gap(i));
+    }
+}
+
+
+TEST(FaultInjector, SameSeedSameDraws) {
+    FaultConfig config;
+    config.distribution = LatencyDistribution::EXPONENTIAL;
+    config.latency = 0.05;
+    FaultInjector a(2, 42), b(2, 42), c(2, 43);
+    a.configure(1, config);
+    b.configure(1, config);
+    c.configure(1, config);
+    std::vector<int64_t> first, second, other;
+    for (int i = 0; i < 100; i++) {
+        first.push_back(a.latency_ns(1));
+        second.push_back(b.latency_ns(1));
+        other.push_back(c.latency_ns(1));
+    }
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first, other);
+}
+
+
+TEST(FaultInjector, LatencyFollowsItsDistribution) {
+    FaultConfig config;
+    config.latency = 0.1;
+    config.jitter = 0.02;
+
+    FaultInjector constant(1, 7);
+    constant.configure(0, config);
+    EXPECT_EQ(constant.latency_ns(0), 100000000);
+
+    for (auto distribution : {LatencyDistribution::UNIFORM, LatencyDistribution::NORMAL,
+                              LatencyDistribution::EXPONENTIAL, LatencyDistribution::LOGNORMAL}) {
+        config.distribution = distribution;
+        FaultInjector faults(1, 7);
+        faults.configure(0, config);
+        EXPECT_NEAR(mean_latency(faults, 20000), 0.1, 0.005) << static_cast<int>(distribution);
+    }
+
+    config.distribution = LatencyDistribution::UNIFORM;
+    FaultInjector bounded(1, 7);
+    bounded.configure(0, config);
+    for (int i = 0; i < 1000; i++) {
+        const int64_t latency = bounded.latency_ns(0);
+        ASSERT_GE(latency, 80000000);
+        ASSERT_LE(latency, 120000000);
+    }
+}
+
+
+TEST(FaultInjector, ProbabilitiesHold) {
+    FaultConfig config;
+    config.drop_feedback = 0.3;
+    config.reject = 0.1;
+    FaultInjector faults(1, 3);
+    faults.configure(0, config);
+    int dropped = 0, rejected = 0;
+    for (int i = 0; i < 10000; i++) {
+        dropped += faults.drop_feedback(0);
+        if (faults.admit(0))
+            faults.release(0);
+        else
+            rejected++;
+    }
+    EXPECT_NEAR(dropped / 10000.0, 0.3, 0.02);
+    EXPECT_NEAR(rejected / 10000.0, 0.1, 0.02);
+}
+
+
+TEST(FaultInjector, RejectsBeyondMaxInFlight) {
+    FaultConfig config;
+    config.max_in_flight = 2;
+    FaultInjector faults(1, 0);
+    faults.configure(0, config);
+    EXPECT_TRUE(faults.admit(0));
+    EXPECT_TRUE(faults.admit(0));
+    EXPECT_FALSE(faults.admit(0));
+    faults.release(0);
+    EXPECT_TRUE(faults.admit(0));
+}
+
+
+TEST(FaultInjector, StallsWithinStallAfter) {
+    FaultConfig config;
+    config.stall = 1.0;
+    config.stall_after = 0.5;
+    FaultInjector faults(1, 0);
+    faults.configure(0, config);
+    for (int i = 0; i < 1000; i++) {
+        const int64_t stall = faults.stall_ns(0);
+        ASSERT_GE(stall, 0);
+        ASSERT_LT(stall, 500000000);
+    }
+}
+
+
+TEST(FaultInjector, GapsLastTheirDuration) {
+    FaultInjector faults(1, 0);
+    faults.configure_gaps(1.0, 100);
+    EXPECT_TRUE(faults.in_gap(1000));
+    EXPECT_TRUE(faults.in_gap(1099));
+    faults.configure_gaps(0.0, 100);
+    EXPECT_FALSE(faults.in_gap(1100));
+}
@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "hal_fake_ptu/goal_scheduler.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+constexpr int64_t TICK_NS = 10000000;
+
+const std::array<AxisConfig, AXIS_COUNT> axes{{{0.1, 0.2, 0.01}, {0.1, 0.2, 0.01}}};
+
+MoveCommand pan_to(double target, std::vector<MoveStatus> & done) {
+    MoveCommand command;
+    command.active[PAN] = true;
+    command.target[PAN] = target;
+    command.on_done = [&done](MoveStatus status) { done.push_back(status); };
+    return command;
+}
+
+void run(GoalScheduler & scheduler, MotionEngine & engine, int64_t & stamp_ns, double seconds) {
+    for (int64_t end = stamp_ns + static_cast<int64_t>(seconds * 1e9); stamp_ns < end; stamp_ns += TICK_NS) {
+        scheduler.poll();
+        engine.tick(stamp_ns);
+    }
+}
+
+}  // namespace
+
+
+TEST(GoalScheduler, ParsesPolicyNames) {
+    EXPECT_EQ(scheduling_policy_from_string("preempt"), SchedulingPolicy::PREEMPT);
+    EXPECT_EQ(scheduling_policy_from_string("queue"), SchedulingPolicy::QUEUE);
+    EXPECT_EQ(scheduling_policy_from_string("reject"), SchedulingPolicy::REJECT);
+    EXPECT_THROW(scheduling_policy_from_string("fifo"), std::invalid_argument);
+}
+
+
+TEST(GoalScheduler, PreemptAbortsTheRunningGoal) {
+    MotionEngine engine(1, axes);
+    GoalScheduler scheduler(engine, SchedulingPolicy::PREEMPT, 0);
+    std::vector<MoveStatus> first, second;
+    int64_t stamp_ns = 0;
+
+    scheduler.submit(pan_to(0.3, first));
+    run(scheduler, engine, stamp_ns, 0.5);
+    EXPECT_TRUE(scheduler.admit({{true, false}}));
+    scheduler.submit(pan_to(0.1, second));
+    run(scheduler, engine, stamp_ns, 5.0);
+
+    EXPECT_EQ(first, std::vector<MoveStatus>{MoveStatus::ABORTED});
+    EXPECT_EQ(second, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+}
+
+
+TEST(GoalScheduler, QueueRunsGoalsInOrderUpToItsBound) {
+    MotionEngine engine(1, axes);
+    GoalScheduler scheduler(engine, SchedulingPolicy::QUEUE, 1);
+    std::vector<MoveStatus> first, second, third;
+    int64_t stamp_ns = 0;
+
+    scheduler.submit(pan_to(0.1, first));
+    scheduler.submit(pan_to(0.2, second));
+    EXPECT_FALSE(scheduler.admit({{true, false}}));
+    EXPECT_TRUE(scheduler.admit({{false, true}}));
+    scheduler.submit(pan_to(0.3, third));
+    EXPECT_EQ(third, std::vector<MoveStatus>{MoveStatus::ABORTED});
+
+    run(scheduler, engine, stamp_ns, 10.0);
+    EXPECT_EQ(first, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+    EXPECT_EQ(second, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.2);
+}
+
+
+TEST(GoalScheduler, QueuedGoalCanBeCanceled) {
+    MotionEngine engine(1, axes);
+    GoalScheduler scheduler(engine, SchedulingPolicy::QUEUE, 4);
+    std::vector<MoveStatus> first, second;
+    int64_t stamp_ns = 0;
+
+    scheduler.submit(pan_to(0.1, first));
+    MoveCommand queued = pan_to(0.2, second);
+    queued.is_canceling = []() { return true; };
+    scheduler.submit(std::move(queued));
+
+    run(scheduler, engine, stamp_ns, 0.1);
+    EXPECT_EQ(second, std::vector<MoveStatus>{MoveStatus::CANCELED});
+    run(scheduler, engine, stamp_ns, 5.0);
+    EXPECT_EQ(first, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+}
+
+
+// A service move preempting the running goal keeps the queued one waiting until it ends
+TEST(GoalScheduler, QueuedGoalWaitsForAPostedMove) {
+    MotionEngine engine(1, axes);
+    GoalScheduler scheduler(engine, SchedulingPolicy::QUEUE, 4);
+    std::vector<MoveStatus> first, second, service;
+    int64_t stamp_ns = 0;
+
+    scheduler.submit(pan_to(0.3, first));
+    scheduler.submit(pan_to(0.2, second));
+    run(scheduler, engine, stamp_ns, 0.5);
+    scheduler.post(pan_to(-0.1, service));
+    run(scheduler, engine, stamp_ns, 0.1);
+    EXPECT_EQ(first, std::vector<MoveStatus>{MoveStatus::ABORTED});
+    EXPECT_TRUE(second.empty());
+
+    run(scheduler, engine, stamp_ns, 10.0);
+    EXPECT_EQ(service, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+    EXPECT_EQ(second, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.2);
+}
+
+
+TEST(GoalScheduler, RejectRefusesWhileBusy) {
+    MotionEngine engine(1, axes);
+    GoalScheduler scheduler(engine, SchedulingPolicy::REJECT, 0);
+    std::vector<MoveStatus> first, second;
+    int64_t stamp_ns = 0;
+
+    scheduler.submit(pan_to(0.1, first));
+    EXPECT_FALSE(scheduler.admit({{true, true}}));
+    scheduler.submit(pan_to(0.2, second));
+    EXPECT_EQ(second, std::vector<MoveStatus>{MoveStatus::ABORTED});
+
+    run(scheduler, engine, stamp_ns, 5.0);
+    EXPECT_EQ(first, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+    EXPECT_TRUE(scheduler.admit({{true, true}}));
+}
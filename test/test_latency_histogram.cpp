@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "hal_fake_ptu/latency_histogram.hpp"
+
+using hal_fake_ptu::LatencyHistogram;
+using hal_fake_ptu::LatencySummary;
+
+
+TEST(LatencyHistogram, EmptyWindowIsZero) {
+    LatencyHistogram histogram;
+    LatencySummary summary = histogram.collect();
+    EXPECT_EQ(summary.count, 0u);
+    EXPECT_EQ(summary.max_ns, 0);
+}
+
+
+TEST(LatencyHistogram, PercentilesWithinBucketPrecision) {
+    LatencyHistogram histogram;
+    for (int64_t us = 1; us <= 1000; us++)
+        histogram.record(us * 1000);
+
+    LatencySummary summary = histogram.collect();
+    EXPECT_EQ(summary.count, 1000u);
+    EXPECT_EQ(summary.max_ns, 1000000);
+    EXPECT_NEAR(summary.p50_ns, 500000, 500000 * 0.04);
+    EXPECT_NEAR(summary.p99_ns, 990000, 990000 * 0.04);
+    EXPECT_GE(summary.p99_ns, 990000);
+}
+
+
+// One repeated value, reported from its bucket rather than clipped to the max
+TEST(LatencyHistogram, SingleValuesWithinBucketPrecision) {
+    for (int64_t ns : {40, 63, 64, 1100, 5000, 123457, 3000000, 999999999}) {
+        LatencyHistogram histogram;
+        for (int i = 0; i < 99; i++)
+            histogram.record(ns);
+        histogram.record(ns * 10);
+
+        LatencySummary summary = histogram.collect();
+        EXPECT_GE(summary.p50_ns, ns) << ns;
+        EXPECT_LE(summary.p50_ns, ns + ns / 32) << ns;
+        EXPECT_GE(summary.p99_ns, ns) << ns;
+        EXPECT_LE(summary.p99_ns, ns + ns / 32) << ns;
+    }
+}
+
+
+TEST(LatencyHistogram, SmallValuesAreExact) {
+    LatencyHistogram histogram;
+    for (int i = 0; i < 10; i++)
+        histogram.record(7);
+
+    LatencySummary summary = histogram.collect();
+    EXPECT_EQ(summary.p50_ns, 7);
+    EXPECT_EQ(summary.p99_ns, 7);
+}
+
+
+TEST(LatencyHistogram, CollectStartsANewWindow) {
+    LatencyHistogram histogram;
+    histogram.record(5000000);
+    histogram.collect();
+    histogram.record(100);
+
+    LatencySummary summary = histogram.collect();
+    EXPECT_EQ(summary.count, 1u);
+    EXPECT_EQ(summary.max_ns, 100);
+}
+
+
+TEST(LatencyHistogram, ConcurrentRecordsAreAllCounted) {
+    LatencyHistogram histogram;
+    std::vector<std::thread> writers;
+    for (int thread = 0; thread < 4; thread++) {
+        writers.emplace_back([&histogram, thread]() {
+            for (int i = 0; i < 10000; i++)
+                histogram.record((thread + 1) * 1000);
+        });
+    }
+    for (auto & writer : writers)
+        writer.join();
+
+    LatencySummary summary = histogram.collect();
+    EXPECT_EQ(summary.count, 40000u);
+    EXPECT_EQ(summary.max_ns, 4000);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "hal_fake_ptu/mapped_log.hpp"
+#include "hal_fake_ptu/trace_buffer.hpp"
+
+using hal_fake_ptu::MappedLog;
+using hal_fake_ptu::TraceBuffer;
+using hal_fake_ptu::TraceEvent;
+using hal_fake_ptu::TraceRecord;
+
+namespace {
+
+TraceRecord sample(int64_t stamp_ns, double position) {
+    return {stamp_ns, 0, static_cast<uint16_t>(TraceEvent::SAMPLE), 0, {position, 0.0}};
+}
+
+long file_size(const std::string & path) {
+    std::FILE * file = std::fopen(path.c_str(), "rb");
+    if (not file)
+        return -1;
+    std::fseek(file, 0, SEEK_END);
+    const long size = std::ftell(file);
+    std::fclose(file);
+    return size;
+}
+
+}  // namespace
+
+
+TEST(MappedLog, ReadsBackWhatWasAppended) {
+    const std::string path = ::testing::TempDir() + "log_roundtrip.bin";
+    {
+        auto log = MappedLog::create(path, 1000);
+        for (int i = 0; i < 10; i++)
+            EXPECT_TRUE(log->append(sample(i, i * 0.25)));
+        EXPECT_EQ(log->size(), 10u);
+    }
+    // Trimmed to the records on close
+    EXPECT_EQ(file_size(path), static_cast<long>(sizeof(TraceBuffer::TraceFileHeader) + 10 * sizeof(TraceRecord)));
+
+    auto log = MappedLog::open(path);
+    ASSERT_EQ(log->size(), 10u);
+    for (int i = 0; i < 10; i++) {
+        EXPECT_EQ((*log)[i].stamp_ns, i);
+        EXPECT_EQ((*log)[i].value[0], i * 0.25);
+    }
+    std::remove(path.c_str());
+}
+
+
+// Killed without closing the log: what was checkpointed is still there
+TEST(MappedLog, KeepsCheckpointedRecordsWithoutClose) {
+    const std::string path = ::testing::TempDir() + "log_crash.bin";
+    const pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        auto log = MappedLog::create(path, 1000);
+        for (int i = 0; i < 5; i++)
+            log->append(sample(i, i * 0.25));
+        log->checkpoint();
+        log->append(sample(5, 1.25));
+        _exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+
+    auto log = MappedLog::open(path);
+    ASSERT_EQ(log->size(), 5u);
+    EXPECT_EQ((*log)[4].value[0], 1.0);
+    std::remove(path.c_str());
+}
+
+
+TEST(MappedLog, CountsAppendsPastCapacity) {
+    const std::string path = ::testing::TempDir() + "log_full.bin";
+    {
+        auto log = MappedLog::create(path, 4);
+        std::vector<std::thread> writers;
+        for (int thread = 0; thread < 3; thread++)
+            writers.emplace_back([&log]() {
+                for (int i = 0; i < 2; i++)
+                    log->append(sample(i, 0.0));
+            });
+        for (auto & writer : writers)
+            writer.join();
+        EXPECT_EQ(log->size(), 4u);
+        EXPECT_EQ(log->dropped(), 2u);
+    }
+    EXPECT_EQ(MappedLog::open(path)->size(), 4u);
+    std::remove(path.c_str());
+}
+
+
+TEST(MappedLog, OpensTraceDumps) {
+    const std::string path = ::testing::TempDir() + "log_dump.bin";
+    TraceBuffer trace(8);
+    trace.record(TraceEvent::RESET, 42, 3, 0);
+    ASSERT_EQ(trace.dump(path), 1);
+
+    auto log = MappedLog::open(path);
+    ASSERT_EQ(log->size(), 1u);
+    EXPECT_EQ((*log)[0].stamp_ns, 42);
+    EXPECT_EQ((*log)[0].unit, 3u);
+    std::remove(path.c_str());
+}
+
+
+TEST(MappedLog, RejectsOtherFiles) {
+    const std::string path = ::testing::TempDir() + "log_garbage.bin";
+    std::FILE * file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("definitely not a trace file at all", file);
+    std::fclose(file);
+
+    EXPECT_THROW(MappedLog::open(path), std::runtime_error);
+    EXPECT_THROW(MappedLog::open(path + ".missing"), std::system_error);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,296 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "hal_fake_ptu/motion_engine.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+constexpr int64_t TICK_NS = 10000000;  // 100 Hz
+
+const std::array<AxisConfig, AXIS_COUNT> axes{{{0.1, 0.2, 0.01}, {0.1, 0.2, 0.01}}};
+
+MoveCommand pan_to(double target, std::vector<MoveStatus> & done, std::size_t unit = 0) {
+    MoveCommand command;
+    command.unit = unit;
+    command.active[PAN] = true;
+    command.target[PAN] = target;
+    command.on_done = [&done](MoveStatus status) { done.push_back(status); };
+    return command;
+}
+
+void run(MotionEngine & engine, int64_t & stamp_ns, double seconds) {
+    for (int64_t end = stamp_ns + static_cast<int64_t>(seconds * 1e9); stamp_ns < end; stamp_ns += TICK_NS)
+        engine.tick(stamp_ns);
+}
+
+}  // namespace
+
+
+TEST(MotionEngine, MoveSucceedsAtTarget) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> done;
+    int64_t stamp_ns = 0;
+
+    engine.post(pan_to(0.2, done));
+    run(engine, stamp_ns, 1.0);
+    EXPECT_TRUE(done.empty());
+    EXPECT_TRUE(engine.sample(0, stamp_ns).moving[PAN]);
+
+    run(engine, stamp_ns, 3.0);
+    ASSERT_EQ(done.size(), 1u);
+    EXPECT_EQ(done[0], MoveStatus::SUCCEEDED);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.2);
+    EXPECT_FALSE(engine.sample(0, stamp_ns).moving[PAN]);
+}
+
+
+TEST(MotionEngine, PredictionMatchesTheMoveAsRun) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> done;
+    int64_t stamp_ns = 0;
+
+    engine.post(pan_to(0.2, done));
+    engine.tick(stamp_ns);
+    const int64_t stamps[3] = {stamp_ns + 500000000, stamp_ns + 1000000000, stamp_ns + 60000000000};
+    PTUState predicted[3];
+    const int64_t rest_ns = engine.predict(0, stamps, 3, predicted);
+    EXPECT_GT(rest_ns, stamp_ns);
+    EXPECT_TRUE(predicted[0].moving[PAN]);
+    EXPECT_FALSE(predicted[2].moving[PAN]);
+    EXPECT_DOUBLE_EQ(predicted[2].position[PAN], 0.2);
+
+    run(engine, stamp_ns, 0.5);
+    EXPECT_NEAR(engine.sample(0, stamp_ns).position[PAN], predicted[0].position[PAN], 1e-9);
+
+    // Done at the first tick at or after the predicted rest
+    while (done.empty())
+        engine.tick(stamp_ns += TICK_NS);
+    EXPECT_GE(stamp_ns, rest_ns);
+    EXPECT_LT(stamp_ns, rest_ns + TICK_NS);
+}
+
+
+TEST(MotionEngine, StartIsReportedAtTheAdoptingTick) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> done;
+    std::vector<int64_t> started;
+    int64_t stamp_ns = 0;
+
+    MoveCommand command = pan_to(0.0, done);
+    command.on_start = [&started, &stamp_ns]() { started.push_back(stamp_ns); };
+    engine.post(std::move(command));
+    EXPECT_TRUE(started.empty());
+
+    // Already at the target: started and done within the same tick
+    engine.tick(stamp_ns);
+    ASSERT_EQ(started.size(), 1u);
+    EXPECT_EQ(started[0], 0);
+    ASSERT_EQ(done.size(), 1u);
+    EXPECT_EQ(done[0], MoveStatus::SUCCEEDED);
+}
+
+
+TEST(MotionEngine, NewerMoveAbortsTheRunningOne) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> first, second;
+    int64_t stamp_ns = 0;
+
+    engine.post(pan_to(0.5, first));
+    run(engine, stamp_ns, 0.5);
+    engine.post(pan_to(-0.1, second));
+    run(engine, stamp_ns, 10.0);
+
+    ASSERT_EQ(first.size(), 1u);
+    EXPECT_EQ(first[0], MoveStatus::ABORTED);
+    ASSERT_EQ(second.size(), 1u);
+    EXPECT_EQ(second[0], MoveStatus::SUCCEEDED);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], -0.1);
+}
+
+
+TEST(MotionEngine, CancelBrakesAndReportsCanceled) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> done;
+    bool canceling = false;
+    int64_t stamp_ns = 0;
+
+    MoveCommand command = pan_to(0.5, done);
+    command.is_canceling = [&canceling]() { return canceling; };
+    engine.post(std::move(command));
+    run(engine, stamp_ns, 2.0);
+
+    canceling = true;
+    run(engine, stamp_ns, 2.0);
+    ASSERT_EQ(done.size(), 1u);
+    EXPECT_EQ(done[0], MoveStatus::CANCELED);
+
+    const PTUState state = engine.sample(0, stamp_ns);
+    EXPECT_FALSE(state.moving[PAN]);
+    EXPECT_GT(state.position[PAN], 0.0);
+    EXPECT_LT(state.position[PAN], 0.5);
+}
+
+
+TEST(MotionEngine, UnitsMoveIndependently) {
+    MotionEngine engine(3, axes);
+    std::vector<MoveStatus> done;
+    int64_t stamp_ns = 0;
+
+    engine.post(pan_to(0.1, done, 0));
+    engine.post(pan_to(-0.1, done, 2));
+    run(engine, stamp_ns, 5.0);
+
+    EXPECT_EQ(done.size(), 2u);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.1);
+    EXPECT_DOUBLE_EQ(engine.sample(1, stamp_ns).position[PAN], 0.0);
+    EXPECT_DOUBLE_EQ(engine.sample(2, stamp_ns).position[PAN], -0.1);
+}
+
+
+MoveCommand path(const std::vector<double> & targets, double blend, std::vector<MoveStatus> & done,
+                 std::vector<std::size_t> & segments) {
+    MoveCommand command;
+    command.active = {{true, true}};
+    for (double target : targets) {
+        Waypoint waypoint;
+        waypoint.target = {{target, -target}};
+        command.waypoints.push_back(waypoint);
+    }
+    command.blend = blend;
+    command.on_segment = [&segments](std::size_t segment) { segments.push_back(segment); };
+    command.on_done = [&done](MoveStatus status) { done.push_back(status); };
+    return command;
+}
+
+
+TEST(MotionEngine, WaypointsAreFollowedInOrder) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> done;
+    std::vector<std::size_t> segments;
+    int64_t stamp_ns = 0;
+
+    engine.post(path({0.1, 0.2, 0.05}, 0.0, done, segments));
+    run(engine, stamp_ns, 10.0);
+
+    ASSERT_EQ(done.size(), 1u);
+    EXPECT_EQ(done[0], MoveStatus::SUCCEEDED);
+    EXPECT_EQ(segments, (std::vector<std::size_t>{1, 2}));
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.05);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[TILT], -0.05);
+}
+
+
+TEST(MotionEngine, BlendingSkipsTheStops) {
+    std::vector<double> targets{0.05, 0.1, 0.15, 0.2};
+    int64_t stopping_ns = 0, blending_ns = 0;
+    for (double blend : {0.0, 0.02}) {
+        MotionEngine engine(1, axes);
+        std::vector<MoveStatus> done;
+        std::vector<std::size_t> segments;
+        int64_t stamp_ns = 0;
+        engine.post(path(targets, blend, done, segments));
+        while (done.empty() and stamp_ns < 20000000000)
+            engine.tick(stamp_ns += TICK_NS);
+        ASSERT_EQ(done.size(), 1u);
+        EXPECT_EQ(segments.size(), 3u);
+        EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.2);
+        (blend > 0.0 ? blending_ns : stopping_ns) = stamp_ns;
+    }
+    EXPECT_LT(blending_ns, stopping_ns);
+}
+
+
+TEST(MotionEngine, TimedWaypointArrivesOnTime) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> done;
+    int64_t stamp_ns = 0;
+
+    MoveCommand command = pan_to(0.0, done);
+    Waypoint waypoint;
+    waypoint.target[PAN] = 0.1;
+    waypoint.duration_ns = 3000000000;  // the limits would take 1.5 s
+    command.waypoints.push_back(waypoint);
+    engine.post(std::move(command));
+
+    while (done.empty())
+        engine.tick(stamp_ns += TICK_NS);
+    EXPECT_NEAR(stamp_ns * 1e-9, 3.0, 0.02);
+}
+
+
+TEST(MotionEngine, ConfigureReplansTheRunningMove) {
+    MotionEngine engine(2, axes);
+    std::vector<MoveStatus> done;
+    int64_t stamp_ns = 0;
+
+    engine.post(pan_to(0.5, done, 0));
+    engine.post(pan_to(0.5, done, 1));
+    run(engine, stamp_ns, 1.0);
+
+    std::array<AxisConfig, AXIS_COUNT> faster = axes;
+    faster[PAN] = {0.2, 0.4, 0.01};
+    engine.configure(faster);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).speed[PAN], 0.1);
+    engine.tick(stamp_ns);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).speed[PAN], 0.2);
+    EXPECT_DOUBLE_EQ(engine.sample(1, stamp_ns).speed[PAN], 0.2);
+
+    // 0.5 at 0.1 would take over 5 s
+    run(engine, stamp_ns, 3.0);
+    ASSERT_EQ(done.size(), 2u);
+    EXPECT_EQ(done[0], MoveStatus::SUCCEEDED);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.5);
+    EXPECT_DOUBLE_EQ(engine.sample(1, stamp_ns).position[PAN], 0.5);
+}
+
+
+TEST(MotionEngine, LatestSetpointWins) {
+    MotionEngine engine(1, axes);
+    int64_t stamp_ns = 0;
+
+    engine.set_setpoint(0, TILT, 0.3, 1.0);
+    engine.set_setpoint(0, TILT, -0.05, 1.0);
+    run(engine, stamp_ns, 5.0);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[TILT], -0.05);
+}
+
+
+// A setpoint takes over its own axis only, never the moves on other axes or units
+TEST(MotionEngine, SetpointLeavesOtherAxesAlone) {
+    MotionEngine engine(2, axes);
+    std::vector<MoveStatus> own_unit, other_unit;
+    int64_t stamp_ns = 0;
+
+    MoveCommand tilt;
+    tilt.active[TILT] = true;
+    tilt.target[TILT] = 0.2;
+    tilt.on_done = [&own_unit](MoveStatus status) { own_unit.push_back(status); };
+    engine.post(std::move(tilt));
+    engine.post(pan_to(0.2, other_unit, 1));
+    run(engine, stamp_ns, 0.5);
+
+    engine.set_setpoint(0, PAN, 0.1, 1.0);
+    run(engine, stamp_ns, 5.0);
+    EXPECT_EQ(own_unit, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+    EXPECT_EQ(other_unit, std::vector<MoveStatus>{MoveStatus::SUCCEEDED});
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.1);
+    EXPECT_DOUBLE_EQ(engine.sample(1, stamp_ns).position[PAN], 0.2);
+}
+
+
+TEST(MotionEngine, ResetAbortsAndReturnsToZero) {
+    MotionEngine engine(1, axes);
+    std::vector<MoveStatus> done;
+    int64_t stamp_ns = 0;
+
+    engine.post(pan_to(0.5, done));
+    run(engine, stamp_ns, 1.0);
+    engine.reset(0);
+
+    ASSERT_EQ(done.size(), 1u);
+    EXPECT_EQ(done[0], MoveStatus::ABORTED);
+    EXPECT_DOUBLE_EQ(engine.sample(0, stamp_ns).position[PAN], 0.0);
+}
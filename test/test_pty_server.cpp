@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include "hal_fake_ptu/pty_server.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+// Parked unit that takes every command, 0.001 per step
+SerialHandlers parked() {
+    SerialHandlers handlers;
+    handlers.state = []() {
+        PTUState state;
+        state.position = {{0.25, -0.125}};
+        return state;
+    };
+    handlers.range = [](Axis) { return std::make_pair(-1.0, 1.0); };
+    handlers.move = [](Axis, double, std::function<void()> settled) { settled(); };
+    handlers.set_speed = [](Axis, double) {};
+    handlers.halt = [](Axis) {};
+    handlers.reset = []() {};
+    return handlers;
+}
+
+// Reads until lines response lines arrived or a second passed without any
+std::string read_lines(int fd, std::size_t lines) {
+    std::string received;
+    char buffer[4096];
+    pollfd ready{fd, POLLIN, 0};
+    while (static_cast<std::size_t>(std::count(received.begin(), received.end(), '\n')) < lines and
+           poll(&ready, 1, 1000) > 0) {
+        const ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count <= 0)
+            break;
+        received.append(buffer, static_cast<std::size_t>(count));
+    }
+    return received;
+}
+
+}  // namespace
+
+
+TEST(PtyServer, AnswersOnTheSlaveDevice) {
+    SerialProtocol protocol(parked(), 0.001);
+    PtyServer server(protocol);
+    server.start();
+
+    const int port = open(server.device().c_str(), O_RDWR | O_NOCTTY);
+    ASSERT_GE(port, 0);
+    const std::string commands = "PP TP\rPP100 ";
+    ASSERT_EQ(write(port, commands.data(), commands.size()), static_cast<ssize_t>(commands.size()));
+    EXPECT_EQ(read_lines(port, 3), "* 250\r\n* -125\r\n*\r\n");
+    EXPECT_EQ(server.received(), commands.size());
+    close(port);
+}
+
+
+TEST(PtyServer, ThousandsOfPipelinedCommands) {
+    SerialProtocol protocol(parked(), 0.001);
+    PtyServer server(protocol);
+    server.start();
+
+    const int port = open(server.device().c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    ASSERT_GE(port, 0);
+    std::string commands;
+    for (int i = 0; i < 5000; i++)
+        commands += "PP" + std::to_string(i % 1000) + " ";
+
+    // Written while the responses are read, so both directions back up on the way
+    std::string received;
+    std::size_t sent = 0;
+    char buffer[4096];
+    for (int idle = 0; received.size() < 5000 * 3 and idle < 1000;) {
+        if (sent < commands.size()) {
+            const ssize_t count = write(port, commands.data() + sent, commands.size() - sent);
+            if (count > 0)
+                sent += static_cast<std::size_t>(count);
+        }
+        const ssize_t count = read(port, buffer, sizeof(buffer));
+        if (count > 0) {
+            received.append(buffer, static_cast<std::size_t>(count));
+            idle = 0;
+        } else {
+            idle++;
+            usleep(1000);
+        }
+    }
+    EXPECT_EQ(sent, commands.size());
+    EXPECT_EQ(received.size(), 5000u * 3);
+    EXPECT_EQ(received.find('!'), std::string::npos);
+    close(port);
+}
+
+
+TEST(PtyServer, LinksTheDevice) {
+    const std::string link = "/tmp/hal_fake_ptu_test_serial";
+    unlink(link.c_str());
+    {
+        SerialProtocol protocol(parked(), 0.001);
+        PtyServer server(protocol, link);
+        char target[128] = {};
+        ASSERT_GT(readlink(link.c_str(), target, sizeof(target) - 1), 0);
+        EXPECT_EQ(server.device(), target);
+    }
+    struct stat gone;
+    EXPECT_NE(lstat(link.c_str(), &gone), 0);
+}
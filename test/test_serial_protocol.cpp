@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "hal_fake_ptu/serial_protocol.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+constexpr int64_t TICK_NS = 10000000;
+
+const std::array<AxisConfig, AXIS_COUNT> axes{{{0.1, 0.2, 0.0005}, {0.1, 0.2, 0.0005}}};
+
+// A protocol driving one unit of a real engine, 0.001 per step
+struct Bench {
+    MotionEngine engine{1, axes};
+    int64_t stamp_ns = 0;
+    SerialProtocol protocol{handlers(), 0.001};
+
+    SerialHandlers handlers() {
+        SerialHandlers result;
+        result.state = [this]() { return engine.sample(0, stamp_ns); };
+        result.range = [](Axis) { return std::make_pair(-1.0, 1.0); };
+        result.move = [this](Axis axis, double target, std::function<void()> settled) {
+            MoveCommand command;
+            command.active[axis] = true;
+            command.target[axis] = target;
+            command.on_done = [settled](MoveStatus) { settled(); };
+            engine.post(std::move(command));
+        };
+        result.set_speed = [this](Axis axis, double speed) { engine.set_speed(0, axis, speed); };
+        result.halt = [this](Axis axis) {
+            MoveCommand command;
+            command.active[axis] = true;
+            command.is_canceling = []() { return true; };
+            engine.post(std::move(command));
+        };
+        result.reset = [this]() { engine.reset(0); };
+        return result;
+    }
+
+    void tick() { engine.tick(stamp_ns += TICK_NS); }
+};
+
+}  // namespace
+
+
+TEST(SerialProtocol, PipelinedCommandsAnswerInOrder) {
+    Bench bench;
+    std::string output;
+    const std::string input = "PP100 TP-50 pp\r\n";
+    EXPECT_EQ(bench.protocol.execute(input, output), input.size());
+    EXPECT_EQ(output, "*\r\n*\r\n* 0\r\n");
+
+    while (bench.engine.sample(0, bench.stamp_ns).moving[PAN] or bench.stamp_ns == 0)
+        bench.tick();
+    output.clear();
+    bench.protocol.execute("PP TP ", output);
+    EXPECT_EQ(output, "* 100\r\n* -50\r\n");
+}
+
+
+TEST(SerialProtocol, IncompleteCommandWaitsForItsDelimiter) {
+    Bench bench;
+    std::string output;
+    EXPECT_EQ(bench.protocol.execute("PS PS", output), 3u);
+    EXPECT_EQ(output, "* 100\r\n");
+    EXPECT_EQ(bench.protocol.execute("PS200", output), 0u);
+    EXPECT_EQ(bench.protocol.execute("PS200\n", output), 6u);
+    EXPECT_EQ(output, "* 100\r\n*\r\n");
+    EXPECT_DOUBLE_EQ(bench.engine.sample(0, 0).speed[PAN], 0.2);
+}
+
+
+TEST(SerialProtocol, AwaitHoldsBackTheCommandsAfterIt) {
+    Bench bench;
+    std::string output;
+    const std::string input = "PP200 A PP ";
+    const std::size_t consumed = bench.protocol.execute(input, output);
+    EXPECT_EQ(input.substr(consumed), "PP ");
+    EXPECT_EQ(output, "*\r\n");
+    ASSERT_TRUE(bench.protocol.awaiting());
+
+    // Not before the engine picked the move up and finished it
+    EXPECT_FALSE(bench.protocol.poll(output));
+    int ticks = 0;
+    while (not bench.protocol.poll(output) and ticks++ < 1000)
+        bench.tick();
+    EXPECT_GT(ticks, 100);
+    EXPECT_EQ(output, "*\r\n*\r\n");
+
+    bench.protocol.execute(input.substr(consumed), output);
+    EXPECT_EQ(output, "*\r\n*\r\n* 200\r\n");
+}
+
+
+TEST(SerialProtocol, HaltAndResetAnswerAtOnce) {
+    Bench bench;
+    std::string output;
+    bench.protocol.execute("PP500 TP500 ", output);
+    for (int i = 0; i < 100; i++)
+        bench.tick();
+
+    bench.protocol.execute("H A ", output);
+    int ticks = 0;
+    while (not bench.protocol.poll(output) and ticks++ < 1000)
+        bench.tick();
+    const PTUState halted = bench.engine.sample(0, bench.stamp_ns);
+    EXPECT_GT(halted.position[PAN], 0.0);
+    EXPECT_LT(halted.position[PAN], 0.5);
+
+    bench.protocol.execute("R PP ", output);
+    EXPECT_EQ(output, "*\r\n*\r\n*\r\n*\r\n*\r\n* 0\r\n");
+}
+
+
+TEST(SerialProtocol, ErrorsAndLimits) {
+    Bench bench;
+    std::string output;
+    bench.protocol.execute("PP1001 TP-1001 XX PS0 PPabc PNX P H2 PN TX PR ", output);
+    EXPECT_EQ(output,
+              "! Pan limit\r\n"
+              "! Tilt limit\r\n"
+              "! Illegal command\r\n"
+              "! Illegal argument\r\n"
+              "! Illegal argument\r\n"
+              "! Illegal command\r\n"
+              "! Illegal command\r\n"
+              "! Illegal command\r\n"
+              "* -1000\r\n"
+              "* 1000\r\n"
+              "* 206.2648\r\n");
+    EXPECT_FALSE(bench.engine.sample(0, 0).moving[PAN]);
+
+    output.clear();
+    bench.protocol.execute(std::string(40, 'P') + " ", output);
+    EXPECT_EQ(output, "! Command too long\r\n");
+}
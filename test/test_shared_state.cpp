@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include "hal_fake_ptu/shared_state.hpp"
+#include "hal_fake_ptu/shared_state_writer.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+std::string segment_name() {
+    return "/hal_fake_ptu_test_" + std::to_string(getpid());
+}
+
+}  // namespace
+
+
+TEST(SharedState, ReaderSeesEveryUnit) {
+    auto writer = SharedStateWriter::create(segment_name(), 3);
+    auto reader = SharedStateReader::open(segment_name());
+    ASSERT_EQ(reader->units(), 3u);
+
+    PTUState state;
+    state.stamp_ns = 1000000000;
+    state.position = {{0.5, -0.25}};
+    state.velocity = {{0.1, 0.0}};
+    state.moving = {{true, false}};
+    writer->write(2, state);
+
+    uint64_t sequence = 0;
+    const SharedPose pose = reader->read(2, &sequence);
+    EXPECT_EQ(sequence, 2u);  // the initial value, then this write
+    EXPECT_EQ(pose.stamp_ns, 1000000000);
+    EXPECT_DOUBLE_EQ(pose.position[0], 0.5);
+    EXPECT_DOUBLE_EQ(pose.position[1], -0.25);
+    EXPECT_EQ(pose.moving[0], 1);
+    EXPECT_EQ(pose.moving[1], 0);
+    EXPECT_DOUBLE_EQ(pose.position_at(1500000000)[0], 0.55);
+    EXPECT_DOUBLE_EQ(reader->read(0).position[0], 0.0);
+}
+
+
+TEST(SharedState, SegmentGoesAwayWithTheWriter) {
+    {
+        auto writer = SharedStateWriter::create(segment_name(), 1);
+    }
+    EXPECT_THROW(SharedStateReader::open(segment_name()), std::system_error);
+}
+
+
+TEST(SharedState, ReadsAreNeverTorn) {
+    auto writer = SharedStateWriter::create(segment_name(), 1);
+    auto reader = SharedStateReader::open(segment_name());
+
+    std::atomic<bool> done{false};
+    std::thread writing([&]() {
+        PTUState state;
+        for (int64_t i = 0; not done.load(); i++) {
+            state.stamp_ns = i;
+            state.position = {{static_cast<double>(i), static_cast<double>(-i)}};
+            state.velocity = {{static_cast<double>(2 * i), 0.0}};
+            writer->write(0, state);
+        }
+    });
+
+    uint64_t last = 0;
+    for (int i = 0; i < 200000; i++) {
+        uint64_t sequence;
+        const SharedPose pose = reader->read(0, &sequence);
+        ASSERT_EQ(pose.position[0], static_cast<double>(pose.stamp_ns));
+        ASSERT_EQ(pose.position[1], -static_cast<double>(pose.stamp_ns));
+        ASSERT_EQ(pose.velocity[0], 2.0 * static_cast<double>(pose.stamp_ns));
+        ASSERT_GE(sequence, last);
+        last = sequence;
+    }
+    done.store(true);
+    writing.join();
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+#include "hal_fake_ptu/tick_thread.hpp"
+
+using hal_fake_ptu::TickThread;
+using hal_fake_ptu::TickThreadConfig;
+
+// Load on the host only delays ticks, and a late tick turns the deadlines it
+// overran into missed ones. So ticks + missed never exceeds the deadlines
+// that elapsed, and the assertions below bound that instead of wall time.
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool wait_until(const std::function<bool()> & done, std::chrono::seconds timeout = std::chrono::seconds(30)) {
+    const Clock::time_point end = Clock::now() + timeout;
+    while (not done()) {
+        if (Clock::now() > end)
+            return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+int64_t ns_since(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+
+TEST(TickThread, TicksAtThePeriod) {
+    TickThreadConfig config;
+    config.period_ns = 2000000;  // 500 Hz
+    std::atomic<int> ticks{0};
+    TickThread thread(config, [&ticks]() { ticks++; });
+
+    const Clock::time_point start = Clock::now();
+    EXPECT_TRUE(thread.start().empty());
+    EXPECT_TRUE(wait_until([&ticks]() { return ticks.load() >= 50; }));
+    thread.stop();
+    const int64_t elapsed_ns = ns_since(start);
+
+    // Never ahead of the deadlines
+    const uint64_t missed = thread.collect_missed();
+    EXPECT_LE(ticks.load() + static_cast<int64_t>(missed), elapsed_ns / config.period_ns + 1);
+    EXPECT_EQ(thread.collect_jitter().count, static_cast<uint64_t>(ticks.load()));
+}
+
+
+TEST(TickThread, OverrunsSkipDeadlines) {
+    TickThreadConfig config;
+    config.period_ns = 1000000;
+    std::atomic<int> ticks{0};
+    TickThread thread(config, [&ticks]() {
+        ticks++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    });
+
+    const Clock::time_point start = Clock::now();
+    thread.start();
+    EXPECT_TRUE(wait_until([&ticks]() { return ticks.load() >= 10; }));
+    thread.stop();
+
+    // Every tick takes at least 5 periods, and those are skipped, not caught up on
+    EXPECT_LE(ticks.load(), ns_since(start) / 5000000 + 1);
+    EXPECT_GE(thread.collect_missed(), static_cast<uint64_t>(ticks.load() - 1) * 4);
+    EXPECT_EQ(thread.collect_missed(), 0u);
+}
+
+
+TEST(TickThread, RejectsUnknownPolicy) {
+    TickThreadConfig config;
+    config.policy = "deadline";
+    EXPECT_THROW(TickThread(config, []() {}), std::invalid_argument);
+}
+
+
+TEST(TickThread, PeriodChangesWhileRunning) {
+    TickThreadConfig config;
+    config.period_ns = 20000000;  // 50 Hz
+    std::atomic<int> ticks{0};
+    std::atomic<int64_t> first_ns{0}, last_ns{0};
+    const Clock::time_point start = Clock::now();
+    TickThread thread(config, [&]() {
+        const int64_t now_ns = ns_since(start);
+        if (ticks++ == 0)
+            first_ns = now_ns;
+        last_ns = now_ns;
+    });
+
+    thread.start();
+    thread.set_period(2000000);
+    EXPECT_TRUE(wait_until([&ticks]() { return ticks.load() >= 50; }));
+    thread.stop();
+
+    // At most one tick at the old period: after the first, deadlines come every
+    // 2 ms, run or missed, where the old period would have had a tenth of them
+    const int64_t deadlines = ticks.load() - 1 + static_cast<int64_t>(thread.collect_missed());
+    EXPECT_GE(deadlines, (last_ns - first_ns) / 2000000 / 2);
+    EXPECT_THROW(thread.set_period(0), std::invalid_argument);
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "hal_fake_ptu/timer_wheel.hpp"
+
+using namespace hal_fake_ptu;
+
+namespace {
+
+constexpr int64_t TICK_NS = 1000000;
+
+}  // namespace
+
+
+TEST(TimerWheel, RunsEachCallbackAtItsDueTick) {
+    TimerWheel wheel(TICK_NS, 16);
+    std::vector<int> ran;
+    wheel.schedule(5 * TICK_NS, [&ran](){ ran.push_back(5); });
+    wheel.schedule(2 * TICK_NS + 500, [&ran](){ ran.push_back(2); });
+    wheel.schedule(5 * TICK_NS, [&ran](){ ran.push_back(6); });
+    EXPECT_EQ(wheel.pending(), 3u);
+
+    wheel.advance(2 * TICK_NS);
+    EXPECT_TRUE(ran.empty());
+    wheel.advance(2 * TICK_NS + 500);
+    EXPECT_EQ(ran, std::vector<int>({2}));
+    wheel.advance(4 * TICK_NS);
+    EXPECT_EQ(ran.size(), 1u);
+    wheel.advance(5 * TICK_NS);
+    EXPECT_EQ(ran, std::vector<int>({2, 5, 6}));
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+
+TEST(TimerWheel, EntriesBeyondTheSpanWaitWholeTurns) {
+    TimerWheel wheel(TICK_NS, 8);
+    int ran = 0;
+    wheel.advance(0);
+    wheel.schedule(20 * TICK_NS, [&ran](){ ran++; });
+    for (int64_t tick = 1; tick < 20; tick++) {
+        wheel.advance(tick * TICK_NS);
+        ASSERT_EQ(ran, 0) << tick;
+    }
+    wheel.advance(20 * TICK_NS);
+    EXPECT_EQ(ran, 1);
+}
+
+
+TEST(TimerWheel, LateAndJumpedOverEntriesRunAtTheNextAdvance) {
+    TimerWheel wheel(TICK_NS, 8);
+    std::vector<int64_t> ran;
+    wheel.advance(10 * TICK_NS);
+    wheel.schedule(3 * TICK_NS, [&ran](){ ran.push_back(3); });
+    wheel.schedule(12 * TICK_NS, [&ran](){ ran.push_back(12); });
+    wheel.schedule(30 * TICK_NS, [&ran](){ ran.push_back(30); });
+    wheel.advance(100 * TICK_NS);
+    EXPECT_EQ(ran, std::vector<int64_t>({3, 12, 30}));
+}
+
+
+TEST(TimerWheel, CallbacksCanScheduleAgain) {
+    TimerWheel wheel(TICK_NS, 8);
+    int ran = 0;
+    std::function<void()> again = [&](){
+        if (++ran < 3)
+            wheel.schedule((ran + 1) * TICK_NS, again);
+    };
+    wheel.schedule(TICK_NS, again);
+    for (int64_t tick = 0; tick <= 5; tick++)
+        wheel.advance(tick * TICK_NS);
+    EXPECT_EQ(ran, 3);
+}
+
+
+TEST(TimerWheel, SchedulesFromOtherThreads) {
+    TimerWheel wheel(TICK_NS, 64);
+    std::atomic<int> ran{0};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&wheel, &ran, t](){
+            for (int i = 0; i < 1000; i++)
+                wheel.schedule((t * 1000 + i) % 200 * TICK_NS, [&ran](){ ran++; });
+        });
+    }
+    std::thread ticking([&](){
+        for (int64_t tick = 0; not done.load(); tick++)
+            wheel.advance(tick * TICK_NS / 10);
+    });
+    for (auto & thread : threads)
+        thread.join();
+    done.store(true);
+    ticking.join();
+    wheel.advance(1000 * TICK_NS);
+    EXPECT_EQ(ran.load(), 4000);
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+
+TEST(TimerWheel, KeepsDueStampsAcrossResolutionChanges) {
+    TimerWheel wheel(TICK_NS, 8);
+    std::vector<int> ran;
+    wheel.advance(3 * TICK_NS);
+    wheel.schedule(4 * TICK_NS + 500, [&ran](){ ran.push_back(4); });
+    wheel.schedule(20 * TICK_NS, [&ran](){ ran.push_back(20); });
+    wheel.schedule(41 * TICK_NS, [&ran](){ ran.push_back(41); });
+
+    wheel.set_resolution(TICK_NS / 4);
+    EXPECT_EQ(wheel.pending(), 3u);
+    wheel.advance(4 * TICK_NS);
+    EXPECT_TRUE(ran.empty());
+    wheel.advance(4 * TICK_NS + 500);
+    EXPECT_EQ(ran, std::vector<int>({4}));
+
+    wheel.set_resolution(5 * TICK_NS);
+    wheel.advance(19 * TICK_NS);
+    EXPECT_EQ(ran.size(), 1u);
+    wheel.advance(20 * TICK_NS);
+    EXPECT_EQ(ran, std::vector<int>({4, 20}));
+    wheel.advance(41 * TICK_NS);
+    EXPECT_EQ(ran, std::vector<int>({4, 20, 41}));
+    EXPECT_EQ(wheel.pending(), 0u);
+}
+
+
+TEST(TimerWheel, RejectsAZeroResolution) {
+    EXPECT_THROW(TimerWheel(0), std::invalid_argument);
+    TimerWheel wheel(TICK_NS);
+    EXPECT_THROW(wheel.set_resolution(0), std::invalid_argument);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hal_fake_ptu/trace_buffer.hpp"
+
+using hal_fake_ptu::TraceBuffer;
+using hal_fake_ptu::TraceEvent;
+using hal_fake_ptu::TraceRecord;
+
+namespace {
+
+std::vector<TraceRecord> read_dump(const std::string & path) {
+    std::vector<TraceRecord> records;
+    std::FILE * file = std::fopen(path.c_str(), "rb");
+    if (not file)
+        return records;
+
+    TraceBuffer::TraceFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) == 1 and header.record_size == sizeof(TraceRecord)) {
+        records.resize(header.count);
+        if (std::fread(records.data(), sizeof(TraceRecord), records.size(), file) != records.size())
+            records.clear();
+    }
+    std::fclose(file);
+    return records;
+}
+
+}  // namespace
+
+
+TEST(TraceBuffer, KeepsTheLatestRecordsInOrder) {
+    TraceBuffer trace(5);  // rounded up to 8
+    for (int i = 0; i < 20; i++)
+        trace.record(TraceEvent::SAMPLE, i, 0, 1, i * 0.5, 0.0);
+
+    const std::string path = ::testing::TempDir() + "trace_order.bin";
+    ASSERT_EQ(trace.dump(path), 8);
+    std::vector<TraceRecord> records = read_dump(path);
+    ASSERT_EQ(records.size(), 8u);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_EQ(records[i].stamp_ns, 12 + i);
+        EXPECT_DOUBLE_EQ(records[i].value[0], (12 + i) * 0.5);
+        EXPECT_EQ(records[i].detail, 1);
+    }
+}
+
+
+TEST(TraceBuffer, ConcurrentWritersNeverTearRecords) {
+    TraceBuffer trace(1024);
+    std::vector<std::thread> writers;
+    for (int unit = 0; unit < 4; unit++) {
+        writers.emplace_back([&trace, unit]() {
+            for (int i = 0; i < 10000; i++)
+                trace.record(TraceEvent::COMMAND, i, unit, 0, i, unit);
+        });
+    }
+    for (auto & writer : writers)
+        writer.join();
+
+    const std::string path = ::testing::TempDir() + "trace_concurrent.bin";
+    ASSERT_EQ(trace.dump(path), 1024);
+    for (const TraceRecord & record : read_dump(path)) {
+        EXPECT_DOUBLE_EQ(record.value[0], static_cast<double>(record.stamp_ns));
+        EXPECT_DOUBLE_EQ(record.value[1], static_cast<double>(record.unit));
+    }
+}
+
+
+TEST(TraceBuffer, DisabledRecordsNothing) {
+    TraceBuffer trace(0);
+    EXPECT_FALSE(trace.enabled());
+    trace.record(TraceEvent::RESET, 0, 0, 0);
+    EXPECT_EQ(trace.dump(::testing::TempDir() + "trace_disabled.bin"), 0);
+}
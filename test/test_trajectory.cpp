@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+
+#include "hal_fake_ptu/trajectory.hpp"
+
+using hal_fake_ptu::AxisLimits;
+using hal_fake_ptu::TrajectorySample;
+using hal_fake_ptu::TrapezoidalProfile;
+
+namespace {
+
+const AxisLimits limits{0.1, 0.2};
+constexpr int64_t MS = 1000000;
+
+// Largest velocity and acceleration seen when sampling every millisecond
+void check_limits(const TrapezoidalProfile & profile, double max_v, double max_a) {
+    TrajectorySample previous = profile.at(0);
+    for (int64_t t = MS; t <= profile.end() + MS; t += MS) {
+        TrajectorySample sample = profile.at(t);
+        EXPECT_LE(std::abs(sample.velocity), max_v + 1e-9);
+        EXPECT_LE(std::abs(sample.velocity - previous.velocity), max_a * 1e-3 + 1e-9);
+        previous = sample;
+    }
+}
+
+}  // namespace
+
+
+TEST(TrapezoidalProfile, HoldStaysPut) {
+    TrapezoidalProfile profile = TrapezoidalProfile::hold(0.3, 5 * MS);
+    EXPECT_DOUBLE_EQ(profile.at(0).position, 0.3);
+    EXPECT_DOUBLE_EQ(profile.at(100 * MS).velocity, 0.0);
+    EXPECT_TRUE(profile.finished(5 * MS));
+}
+
+
+TEST(TrapezoidalProfile, CruisesAtTheSpeedLimit) {
+    TrapezoidalProfile profile = TrapezoidalProfile::plan({0.0, 0.0}, 0.7, limits, 0);
+
+    // 0.5 s ramps at each end, 6.5 s cruise
+    EXPECT_NEAR(profile.end() * 1e-9, 7.5, 1e-6);
+    EXPECT_NEAR(profile.at(3000 * MS).velocity, 0.1, 1e-9);
+    EXPECT_DOUBLE_EQ(profile.at(profile.end()).position, 0.7);
+    EXPECT_DOUBLE_EQ(profile.at(profile.end()).velocity, 0.0);
+    check_limits(profile, limits.max_velocity, limits.max_acceleration);
+}
+
+
+TEST(TrapezoidalProfile, ShortMoveIsTriangular) {
+    TrapezoidalProfile profile = TrapezoidalProfile::plan({0.0, 0.0}, -0.01, limits, 0);
+
+    EXPECT_NEAR(profile.end() * 1e-9, 2.0 * std::sqrt(0.01 / 0.2), 1e-6);
+    EXPECT_DOUBLE_EQ(profile.at(profile.end()).position, -0.01);
+    check_limits(profile, std::sqrt(0.01 * 0.2), limits.max_acceleration);
+}
+
+
+TEST(TrapezoidalProfile, ReplanFromMotionKeepsVelocityContinuous) {
+    // Moving away from the new target: brake, then come back
+    TrapezoidalProfile profile = TrapezoidalProfile::plan({0.2, 0.1}, 0.0, limits, 0);
+
+    EXPECT_DOUBLE_EQ(profile.at(0).velocity, 0.1);
+    EXPECT_GT(profile.at(200 * MS).position, 0.2);
+    EXPECT_DOUBLE_EQ(profile.at(profile.end()).position, 0.0);
+    check_limits(profile, limits.max_velocity, limits.max_acceleration);
+}
+
+
+TEST(TrapezoidalProfile, OvershootsWhenTooFastToStop) {
+    TrapezoidalProfile profile = TrapezoidalProfile::plan({0.0, 0.3}, 0.05, limits, 0);
+
+    double furthest = 0.0;
+    for (int64_t t = 0; t <= profile.end(); t += MS)
+        furthest = std::max(furthest, profile.at(t).position);
+
+    // Braking from 0.3 at 0.2 needs 0.225
+    EXPECT_NEAR(furthest, 0.225, 1e-3);
+    EXPECT_DOUBLE_EQ(profile.at(profile.end()).position, 0.05);
+}
+
+
+TEST(TrapezoidalProfile, StopBrakesToRest) {
+    TrapezoidalProfile profile = TrapezoidalProfile::stop({0.1, -0.1}, limits, 0);
+
+    EXPECT_NEAR(profile.end() * 1e-9, 0.5, 1e-6);
+    EXPECT_NEAR(profile.target(), 0.1 - 0.025, 1e-12);
+    EXPECT_DOUBLE_EQ(profile.at(profile.end()).velocity, 0.0);
+}